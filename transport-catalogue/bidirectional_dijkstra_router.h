@@ -0,0 +1,202 @@
+#pragma once
+
+#include "dijkstra_router.h"
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+    // Двунаправленный поиск Дейкстры: прямой поиск от начала по исходящим ребрам и обратный
+    // от цели по входящим, каждый раз продвигается сторона с меньшим весом в начале очереди.
+    // Поиск прекращается, когда сумма весов в начале обеих очередей не меньше лучшего найденного пути
+    template <typename Weight>
+    class BidirectionalDijkstraRouter {
+
+    private:
+
+        using Graph = DirectedWeightedGraph<Weight>;
+
+    public:
+
+        using RouteInfo = graph::RouteInfo<Weight>;
+
+        explicit BidirectionalDijkstraRouter(const Graph& graph);
+
+        std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+        SearchStats GetSearchStats() const;
+
+    private:
+
+        static constexpr size_t FORWARD = 0;
+        static constexpr size_t BACKWARD = 1;
+
+        struct SearchSide {
+            std::vector<Weight> weights;
+            std::vector<EdgeId> prev_edges;
+            std::vector<uint32_t> reached;
+            std::vector<uint32_t> settled;
+            std::vector<std::pair<Weight, VertexId>> queue;
+        };
+
+        // Буферы обеих сторон, как и в DijkstraRouter, - на поток, с номером поиска вместо очистки
+        struct SearchData {
+            std::array<SearchSide, 2> sides;
+            uint32_t epoch = 0;
+
+            void Reset(size_t vertex_count) {
+                if (sides[FORWARD].weights.size() != vertex_count) {
+                    for (SearchSide& side : sides) {
+                        side.weights.assign(vertex_count, ZERO_WEIGHT);
+                        side.prev_edges.assign(vertex_count, 0);
+                        side.reached.assign(vertex_count, 0);
+                        side.settled.assign(vertex_count, 0);
+                    }
+                    epoch = 0;
+                }
+                if (++epoch == 0) {
+                    for (SearchSide& side : sides) {
+                        std::fill(side.reached.begin(), side.reached.end(), 0);
+                        std::fill(side.settled.begin(), side.settled.end(), 0);
+                    }
+                    epoch = 1;
+                }
+                for (SearchSide& side : sides) {
+                    side.queue.clear();
+                }
+            }
+        };
+
+        static SearchData& GetSearchData() {
+            static thread_local SearchData search_data;
+            return search_data;
+        }
+
+        static constexpr Weight ZERO_WEIGHT{};
+        const Graph& graph_;
+        mutable std::atomic<size_t> searches_ = 0;
+        mutable std::atomic<size_t> settled_vertices_ = 0;
+    };
+
+    template <typename Weight>
+    BidirectionalDijkstraRouter<Weight>::BidirectionalDijkstraRouter(const Graph& graph)
+        : graph_(graph)
+    {
+        const size_t edge_count = graph.GetEdgeCount();
+        for (EdgeId edge_id = 0; edge_id < edge_count; ++edge_id) {
+            if (graph.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+        }
+    }
+
+    template <typename Weight>
+    SearchStats BidirectionalDijkstraRouter<Weight>::GetSearchStats() const {
+        return { searches_.load(std::memory_order_relaxed), settled_vertices_.load(std::memory_order_relaxed) };
+    }
+
+    template <typename Weight>
+    std::optional<typename BidirectionalDijkstraRouter<Weight>::RouteInfo>
+        BidirectionalDijkstraRouter<Weight>::BuildRoute(VertexId from, VertexId to) const {
+        const size_t vertex_count = graph_.GetVertexCount();
+        if (from >= vertex_count || to >= vertex_count) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+        searches_.fetch_add(1, std::memory_order_relaxed);
+        if (from == to) {
+            return RouteInfo{ ZERO_WEIGHT, {} };
+        }
+
+        SearchData& data = GetSearchData();
+        data.Reset(vertex_count);
+        const uint32_t epoch = data.epoch;
+        const auto queue_order = std::greater<std::pair<Weight, VertexId>>{};
+
+        const std::array<VertexId, 2> sources = { from, to };
+        for (size_t direction : { FORWARD, BACKWARD }) {
+            SearchSide& side = data.sides[direction];
+            side.weights[sources[direction]] = ZERO_WEIGHT;
+            side.reached[sources[direction]] = epoch;
+            side.queue.push_back({ ZERO_WEIGHT, sources[direction] });
+        }
+
+        // Лучший найденный путь: вес и вершина, в которой встретились поиски
+        std::optional<Weight> best_weight;
+        VertexId meeting_vertex = from;
+        size_t settled_count = 0;
+
+        while (!data.sides[FORWARD].queue.empty() && !data.sides[BACKWARD].queue.empty()) {
+            const Weight forward_top = data.sides[FORWARD].queue.front().first;
+            const Weight backward_top = data.sides[BACKWARD].queue.front().first;
+            if (best_weight && !(forward_top + backward_top < *best_weight)) {
+                break;
+            }
+
+            const size_t direction = forward_top <= backward_top ? FORWARD : BACKWARD;
+            SearchSide& side = data.sides[direction];
+            const SearchSide& other_side = data.sides[1 - direction];
+            std::pop_heap(side.queue.begin(), side.queue.end(), queue_order);
+            const auto [weight, vertex] = side.queue.back();
+            side.queue.pop_back();
+            if (side.settled[vertex] == epoch) {
+                continue;
+            }
+            side.settled[vertex] = epoch;
+            ++settled_count;
+
+            const auto edges = direction == FORWARD ? graph_.GetIncidentEdges(vertex) : graph_.GetIncomingEdges(vertex);
+            for (const EdgeId edge_id : edges) {
+                const auto& edge = graph_.GetEdge(edge_id);
+                const VertexId next_vertex = direction == FORWARD ? edge.to : edge.from;
+                if (side.settled[next_vertex] == epoch) {
+                    continue;
+                }
+                const Weight candidate_weight = weight + edge.weight;
+                if (side.reached[next_vertex] != epoch || candidate_weight < side.weights[next_vertex]) {
+                    side.reached[next_vertex] = epoch;
+                    side.weights[next_vertex] = candidate_weight;
+                    side.prev_edges[next_vertex] = edge_id;
+                    side.queue.push_back({ candidate_weight, next_vertex });
+                    std::push_heap(side.queue.begin(), side.queue.end(), queue_order);
+                }
+                if (other_side.reached[next_vertex] == epoch) {
+                    const Weight path_weight = side.weights[next_vertex] + other_side.weights[next_vertex];
+                    if (!best_weight || path_weight < *best_weight) {
+                        best_weight = path_weight;
+                        meeting_vertex = next_vertex;
+                    }
+                }
+            }
+        }
+        settled_vertices_.fetch_add(settled_count, std::memory_order_relaxed);
+
+        if (!best_weight) {
+            return std::nullopt;
+        }
+
+        // Ребра от начала до точки встречи по прямому поиску, затем от нее до цели по обратному
+        std::vector<EdgeId> edges;
+        const SearchSide& forward = data.sides[FORWARD];
+        const SearchSide& backward = data.sides[BACKWARD];
+        for (VertexId vertex = meeting_vertex; vertex != from; vertex = graph_.GetEdge(forward.prev_edges[vertex]).from) {
+            edges.push_back(forward.prev_edges[vertex]);
+        }
+        std::reverse(edges.begin(), edges.end());
+        for (VertexId vertex = meeting_vertex; vertex != to; vertex = graph_.GetEdge(backward.prev_edges[vertex]).to) {
+            edges.push_back(backward.prev_edges[vertex]);
+        }
+
+        return RouteInfo{ *best_weight, std::move(edges) };
+    }
+
+}  // namespace graph
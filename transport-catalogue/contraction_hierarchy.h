@@ -0,0 +1,483 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+    // Результат предобработки иерархии сокращений: порядок (ранг) вершин и добавленные shortcut-ребра.
+    // Идентификаторы дуг: [0, edge_count) - ребра графа, edge_count + i - shortcuts[i].
+    // Shortcut заменяет путь из двух дуг first и second через сокращенную вершину
+    template <typename Weight>
+    struct ContractionHierarchy {
+        struct Shortcut {
+            VertexId from;
+            VertexId to;
+            Weight weight;
+            EdgeId first;
+            EdgeId second;
+        };
+
+        std::vector<uint32_t> ranks;
+        std::vector<Shortcut> shortcuts;
+    };
+
+    // Поиск маршрута по иерархии сокращений: двунаправленный поиск только вверх по рангам вершин,
+    // найденный путь разворачивается обратно в последовательность исходных ребер графа
+    template <typename Weight>
+    class ContractionHierarchyRouter {
+
+    private:
+
+        using Graph = DirectedWeightedGraph<Weight>;
+        using Hierarchy = ContractionHierarchy<Weight>;
+
+    public:
+
+        using RouteInfo = graph::RouteInfo<Weight>;
+
+        // Предобработка графа (выполняется при make_base)
+        explicit ContractionHierarchyRouter(const Graph& graph);
+        // Восстановление ранее рассчитанной иерархии
+        ContractionHierarchyRouter(const Graph& graph, Hierarchy hierarchy);
+
+        std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+        const Hierarchy& GetHierarchy() const;
+
+    private:
+
+        struct Arc {
+            VertexId vertex;
+            Weight weight;
+            EdgeId arc_id;
+        };
+
+        // Дуги вверх по рангу в плоском виде: дуги вершины v - [offsets[v], offsets[v + 1])
+        struct UpwardArcs {
+            std::vector<size_t> offsets;
+            std::vector<Arc> arcs;
+        };
+
+        struct SearchDirection {
+            std::vector<Weight> weights;
+            std::vector<EdgeId> prev_arcs;
+            std::vector<uint32_t> reached;
+            std::vector<std::pair<Weight, VertexId>> queue;
+        };
+
+        struct SearchData {
+            SearchDirection forward;
+            SearchDirection backward;
+            uint32_t epoch = 0;
+
+            void Reset(size_t vertex_count) {
+                if (forward.weights.size() != vertex_count) {
+                    for (SearchDirection* direction : { &forward, &backward }) {
+                        direction->weights.assign(vertex_count, Weight{});
+                        direction->prev_arcs.assign(vertex_count, 0);
+                        direction->reached.assign(vertex_count, 0);
+                    }
+                    epoch = 0;
+                }
+                if (++epoch == 0) {
+                    std::fill(forward.reached.begin(), forward.reached.end(), 0);
+                    std::fill(backward.reached.begin(), backward.reached.end(), 0);
+                    epoch = 1;
+                }
+                forward.queue.clear();
+                backward.queue.clear();
+            }
+        };
+
+        static SearchData& GetSearchData() {
+            static thread_local SearchData search_data;
+            return search_data;
+        }
+
+        void Contract();
+        void BuildUpwardArcs();
+        void AppendArcEdges(EdgeId arc_id, std::vector<EdgeId>& edges) const;
+        std::tuple<VertexId, VertexId, Weight> GetArc(EdgeId arc_id) const;
+
+        static constexpr size_t WITNESS_SETTLED_LIMIT = 500;
+        static constexpr Weight ZERO_WEIGHT{};
+        static constexpr Weight INFINITE_WEIGHT = std::numeric_limits<Weight>::infinity();
+        const Graph& graph_;
+        Hierarchy hierarchy_;
+        UpwardArcs forward_arcs_;
+        UpwardArcs backward_arcs_;
+    };
+
+    template <typename Weight>
+    ContractionHierarchyRouter<Weight>::ContractionHierarchyRouter(const Graph& graph)
+        : graph_(graph)
+    {
+        Contract();
+        BuildUpwardArcs();
+    }
+
+    template <typename Weight>
+    ContractionHierarchyRouter<Weight>::ContractionHierarchyRouter(const Graph& graph, Hierarchy hierarchy)
+        : graph_(graph)
+        , hierarchy_(std::move(hierarchy))
+    {
+        const size_t vertex_count = graph.GetVertexCount();
+        if (hierarchy_.ranks.size() != vertex_count) {
+            throw std::invalid_argument("Contraction hierarchy doesn't match the graph");
+        }
+        for (size_t i = 0; i < hierarchy_.shortcuts.size(); ++i) {
+            const auto& shortcut = hierarchy_.shortcuts[i];
+            // Shortcut может ссылаться только на дуги, появившиеся раньше него
+            const EdgeId arc_id = graph.GetEdgeCount() + i;
+            if (shortcut.from >= vertex_count || shortcut.to >= vertex_count
+                || shortcut.first >= arc_id || shortcut.second >= arc_id) {
+                throw std::invalid_argument("Contraction hierarchy refers to unknown arc");
+            }
+        }
+        BuildUpwardArcs();
+    }
+
+    template <typename Weight>
+    const ContractionHierarchy<Weight>& ContractionHierarchyRouter<Weight>::GetHierarchy() const {
+        return hierarchy_;
+    }
+
+    template <typename Weight>
+    std::tuple<VertexId, VertexId, Weight> ContractionHierarchyRouter<Weight>::GetArc(EdgeId arc_id) const {
+        if (arc_id < graph_.GetEdgeCount()) {
+            const auto& edge = graph_.GetEdge(arc_id);
+            return { edge.from, edge.to, edge.weight };
+        }
+        const auto& shortcut = hierarchy_.shortcuts[arc_id - graph_.GetEdgeCount()];
+        return { shortcut.from, shortcut.to, shortcut.weight };
+    }
+
+    template <typename Weight>
+    void ContractionHierarchyRouter<Weight>::Contract() {
+        const size_t vertex_count = graph_.GetVertexCount();
+        const size_t edge_count = graph_.GetEdgeCount();
+
+        // Рабочий граф из несокращенных вершин, из параллельных дуг остается самая легкая
+        std::vector<std::vector<Arc>> out_arcs(vertex_count);
+        std::vector<std::vector<Arc>> in_arcs(vertex_count);
+        auto add_arc = [&out_arcs, &in_arcs](VertexId from, VertexId to, Weight weight, EdgeId arc_id) {
+            auto out_it = std::find_if(out_arcs[from].begin(), out_arcs[from].end(),
+                [to](const Arc& arc) { return arc.vertex == to; });
+            if (out_it == out_arcs[from].end()) {
+                out_arcs[from].push_back({ to, weight, arc_id });
+                in_arcs[to].push_back({ from, weight, arc_id });
+            }
+            else if (weight < out_it->weight) {
+                *out_it = { to, weight, arc_id };
+                auto in_it = std::find_if(in_arcs[to].begin(), in_arcs[to].end(),
+                    [from](const Arc& arc) { return arc.vertex == from; });
+                *in_it = { from, weight, arc_id };
+            }
+        };
+        for (EdgeId edge_id = 0; edge_id < edge_count; ++edge_id) {
+            const auto& edge = graph_.GetEdge(edge_id);
+            if (edge.weight < ZERO_WEIGHT) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+            if (edge.from != edge.to) {
+                add_arc(edge.from, edge.to, edge.weight, edge_id);
+            }
+        }
+
+        std::vector<int> contracted_neighbours(vertex_count, 0);
+
+        // Локальный поиск свидетеля: есть ли путь из source в цели, не проходящий через вершину skipped,
+        // не длиннее пути через нее. Поиск ограничен, поэтому иногда добавляются лишние shortcuts -
+        // на корректность это не влияет
+        std::vector<Weight> witness_weights(vertex_count, INFINITE_WEIGHT);
+        std::vector<VertexId> witness_touched;
+        std::vector<std::pair<Weight, VertexId>> witness_queue;
+        const auto queue_order = std::greater<std::pair<Weight, VertexId>>{};
+        auto run_witness_search = [&](VertexId source, VertexId skipped, Weight limit) {
+            for (const VertexId vertex : witness_touched) {
+                witness_weights[vertex] = INFINITE_WEIGHT;
+            }
+            witness_touched.clear();
+            witness_queue.clear();
+            witness_weights[source] = ZERO_WEIGHT;
+            witness_touched.push_back(source);
+            witness_queue.push_back({ ZERO_WEIGHT, source });
+            size_t settled_count = 0;
+            while (!witness_queue.empty() && settled_count < WITNESS_SETTLED_LIMIT) {
+                std::pop_heap(witness_queue.begin(), witness_queue.end(), queue_order);
+                const auto [weight, vertex] = witness_queue.back();
+                witness_queue.pop_back();
+                if (weight > witness_weights[vertex]) {
+                    continue;
+                }
+                if (weight > limit) {
+                    break;
+                }
+                ++settled_count;
+                for (const Arc& arc : out_arcs[vertex]) {
+                    if (arc.vertex == skipped) {
+                        continue;
+                    }
+                    const Weight candidate_weight = weight + arc.weight;
+                    if (candidate_weight < witness_weights[arc.vertex]) {
+                        if (witness_weights[arc.vertex] == INFINITE_WEIGHT) {
+                            witness_touched.push_back(arc.vertex);
+                        }
+                        witness_weights[arc.vertex] = candidate_weight;
+                        witness_queue.push_back({ candidate_weight, arc.vertex });
+                        std::push_heap(witness_queue.begin(), witness_queue.end(), queue_order);
+                    }
+                }
+            }
+        };
+
+        // Обходит пары (вход, выход) вершины, для которых нужен shortcut
+        auto for_each_shortcut = [&](VertexId vertex, const auto& callback) {
+            Weight max_out_weight = ZERO_WEIGHT;
+            for (const Arc& out_arc : out_arcs[vertex]) {
+                max_out_weight = std::max(max_out_weight, out_arc.weight);
+            }
+            for (const Arc& in_arc : in_arcs[vertex]) {
+                run_witness_search(in_arc.vertex, vertex, in_arc.weight + max_out_weight);
+                for (const Arc& out_arc : out_arcs[vertex]) {
+                    if (out_arc.vertex == in_arc.vertex) {
+                        continue;
+                    }
+                    const Weight via_weight = in_arc.weight + out_arc.weight;
+                    if (via_weight < witness_weights[out_arc.vertex]) {
+                        callback(in_arc, out_arc, via_weight);
+                    }
+                }
+            }
+        };
+
+        auto get_priority = [&](VertexId vertex) {
+            int shortcut_count = 0;
+            for_each_shortcut(vertex, [&shortcut_count](const Arc&, const Arc&, Weight) { ++shortcut_count; });
+            const int edge_difference = shortcut_count
+                - static_cast<int>(in_arcs[vertex].size() + out_arcs[vertex].size());
+            return edge_difference + 2 * contracted_neighbours[vertex];
+        };
+
+        std::vector<std::pair<int, VertexId>> priority_queue;
+        const auto priority_order = std::greater<std::pair<int, VertexId>>{};
+        priority_queue.reserve(vertex_count);
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            priority_queue.push_back({ get_priority(vertex), vertex });
+        }
+        std::make_heap(priority_queue.begin(), priority_queue.end(), priority_order);
+
+        hierarchy_.ranks.assign(vertex_count, 0);
+        hierarchy_.shortcuts.clear();
+        uint32_t next_rank = 0;
+        while (!priority_queue.empty()) {
+            std::pop_heap(priority_queue.begin(), priority_queue.end(), priority_order);
+            const VertexId vertex = priority_queue.back().second;
+            priority_queue.pop_back();
+
+            // Ленивое обновление приоритета: если вершина перестала быть лучшей, откладываем ее
+            const int priority = get_priority(vertex);
+            if (!priority_queue.empty() && priority > priority_queue.front().first) {
+                priority_queue.push_back({ priority, vertex });
+                std::push_heap(priority_queue.begin(), priority_queue.end(), priority_order);
+                continue;
+            }
+
+            std::vector<std::tuple<VertexId, VertexId, Weight, EdgeId, EdgeId>> new_shortcuts;
+            for_each_shortcut(vertex, [&new_shortcuts](const Arc& in_arc, const Arc& out_arc, Weight weight) {
+                new_shortcuts.emplace_back(in_arc.vertex, out_arc.vertex, weight, in_arc.arc_id, out_arc.arc_id);
+            });
+
+            hierarchy_.ranks[vertex] = next_rank++;
+            for (const Arc& arc : out_arcs[vertex]) {
+                auto& neighbour_in = in_arcs[arc.vertex];
+                neighbour_in.erase(std::remove_if(neighbour_in.begin(), neighbour_in.end(),
+                    [vertex](const Arc& in_arc) { return in_arc.vertex == vertex; }), neighbour_in.end());
+                ++contracted_neighbours[arc.vertex];
+            }
+            for (const Arc& arc : in_arcs[vertex]) {
+                auto& neighbour_out = out_arcs[arc.vertex];
+                neighbour_out.erase(std::remove_if(neighbour_out.begin(), neighbour_out.end(),
+                    [vertex](const Arc& out_arc) { return out_arc.vertex == vertex; }), neighbour_out.end());
+                ++contracted_neighbours[arc.vertex];
+            }
+            out_arcs[vertex].clear();
+            out_arcs[vertex].shrink_to_fit();
+            in_arcs[vertex].clear();
+            in_arcs[vertex].shrink_to_fit();
+
+            for (const auto& [from, to, weight, first, second] : new_shortcuts) {
+                const EdgeId arc_id = edge_count + hierarchy_.shortcuts.size();
+                hierarchy_.shortcuts.push_back({ from, to, weight, first, second });
+                add_arc(from, to, weight, arc_id);
+            }
+        }
+    }
+
+    template <typename Weight>
+    void ContractionHierarchyRouter<Weight>::BuildUpwardArcs() {
+        const size_t vertex_count = graph_.GetVertexCount();
+        const size_t arc_count = graph_.GetEdgeCount() + hierarchy_.shortcuts.size();
+        const auto& ranks = hierarchy_.ranks;
+
+        forward_arcs_.offsets.assign(vertex_count + 1, 0);
+        backward_arcs_.offsets.assign(vertex_count + 1, 0);
+        for (EdgeId arc_id = 0; arc_id < arc_count; ++arc_id) {
+            const auto [from, to, weight] = GetArc(arc_id);
+            if (ranks[from] < ranks[to]) {
+                ++forward_arcs_.offsets[from + 1];
+            }
+            else if (ranks[from] > ranks[to]) {
+                ++backward_arcs_.offsets[to + 1];
+            }
+        }
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            forward_arcs_.offsets[vertex + 1] += forward_arcs_.offsets[vertex];
+            backward_arcs_.offsets[vertex + 1] += backward_arcs_.offsets[vertex];
+        }
+
+        forward_arcs_.arcs.resize(forward_arcs_.offsets.back());
+        backward_arcs_.arcs.resize(backward_arcs_.offsets.back());
+        std::vector<size_t> forward_positions(forward_arcs_.offsets.begin(), forward_arcs_.offsets.end() - 1);
+        std::vector<size_t> backward_positions(backward_arcs_.offsets.begin(), backward_arcs_.offsets.end() - 1);
+        for (EdgeId arc_id = 0; arc_id < arc_count; ++arc_id) {
+            const auto [from, to, weight] = GetArc(arc_id);
+            if (ranks[from] < ranks[to]) {
+                forward_arcs_.arcs[forward_positions[from]++] = { to, weight, arc_id };
+            }
+            else if (ranks[from] > ranks[to]) {
+                backward_arcs_.arcs[backward_positions[to]++] = { from, weight, arc_id };
+            }
+        }
+    }
+
+    template <typename Weight>
+    void ContractionHierarchyRouter<Weight>::AppendArcEdges(EdgeId arc_id, std::vector<EdgeId>& edges) const {
+        const size_t edge_count = graph_.GetEdgeCount();
+        std::vector<EdgeId> stack{ arc_id };
+        while (!stack.empty()) {
+            const EdgeId current = stack.back();
+            stack.pop_back();
+            if (current < edge_count) {
+                edges.push_back(current);
+            }
+            else {
+                const auto& shortcut = hierarchy_.shortcuts[current - edge_count];
+                stack.push_back(shortcut.second);
+                stack.push_back(shortcut.first);
+            }
+        }
+    }
+
+    template <typename Weight>
+    std::optional<typename ContractionHierarchyRouter<Weight>::RouteInfo>
+        ContractionHierarchyRouter<Weight>::BuildRoute(VertexId from, VertexId to) const {
+        const size_t vertex_count = graph_.GetVertexCount();
+        if (from >= vertex_count || to >= vertex_count) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+        if (from == to) {
+            return RouteInfo{ ZERO_WEIGHT, {} };
+        }
+
+        SearchData& data = GetSearchData();
+        data.Reset(vertex_count);
+        const uint32_t epoch = data.epoch;
+        const auto queue_order = std::greater<std::pair<Weight, VertexId>>{};
+
+        for (auto [direction, source] : { std::pair{ &data.forward, from }, std::pair{ &data.backward, to } }) {
+            direction->weights[source] = ZERO_WEIGHT;
+            direction->reached[source] = epoch;
+            direction->queue.push_back({ ZERO_WEIGHT, source });
+        }
+
+        Weight best_weight = INFINITE_WEIGHT;
+        VertexId meeting_vertex = vertex_count;
+        auto queue_top = [](const SearchDirection& direction) {
+            return direction.queue.empty() ? INFINITE_WEIGHT : direction.queue.front().first;
+        };
+
+        while (true) {
+            const Weight forward_top = queue_top(data.forward);
+            const Weight backward_top = queue_top(data.backward);
+            if (std::min(forward_top, backward_top) >= best_weight) {
+                break;
+            }
+            const bool is_forward = forward_top <= backward_top;
+            SearchDirection& direction = is_forward ? data.forward : data.backward;
+            const SearchDirection& opposite = is_forward ? data.backward : data.forward;
+            const UpwardArcs& upward_arcs = is_forward ? forward_arcs_ : backward_arcs_;
+            const UpwardArcs& downward_arcs = is_forward ? backward_arcs_ : forward_arcs_;
+
+            std::pop_heap(direction.queue.begin(), direction.queue.end(), queue_order);
+            const auto [weight, vertex] = direction.queue.back();
+            direction.queue.pop_back();
+            if (weight > direction.weights[vertex]) {
+                continue;
+            }
+            if (opposite.reached[vertex] == epoch && weight + opposite.weights[vertex] < best_weight) {
+                best_weight = weight + opposite.weights[vertex];
+                meeting_vertex = vertex;
+            }
+            // Stall-on-demand: если до вершины есть более короткий путь через вершину выше рангом,
+            // найденный вес не кратчайший и продолжать поиск из нее незачем
+            bool is_stalled = false;
+            for (size_t i = downward_arcs.offsets[vertex]; i < downward_arcs.offsets[vertex + 1] && !is_stalled; ++i) {
+                const Arc& arc = downward_arcs.arcs[i];
+                is_stalled = direction.reached[arc.vertex] == epoch
+                    && direction.weights[arc.vertex] + arc.weight < weight;
+            }
+            if (is_stalled) {
+                continue;
+            }
+            for (size_t i = upward_arcs.offsets[vertex]; i < upward_arcs.offsets[vertex + 1]; ++i) {
+                const Arc& arc = upward_arcs.arcs[i];
+                const Weight candidate_weight = weight + arc.weight;
+                if (direction.reached[arc.vertex] != epoch || candidate_weight < direction.weights[arc.vertex]) {
+                    direction.reached[arc.vertex] = epoch;
+                    direction.weights[arc.vertex] = candidate_weight;
+                    direction.prev_arcs[arc.vertex] = arc.arc_id;
+                    direction.queue.push_back({ candidate_weight, arc.vertex });
+                    std::push_heap(direction.queue.begin(), direction.queue.end(), queue_order);
+                }
+            }
+        }
+
+        if (meeting_vertex == vertex_count) {
+            return std::nullopt;
+        }
+
+        std::vector<EdgeId> forward_path;
+        for (VertexId vertex = meeting_vertex; vertex != from;) {
+            const EdgeId arc_id = data.forward.prev_arcs[vertex];
+            forward_path.push_back(arc_id);
+            vertex = std::get<0>(GetArc(arc_id));
+        }
+        std::vector<EdgeId> edges;
+        for (auto it = forward_path.rbegin(); it != forward_path.rend(); ++it) {
+            AppendArcEdges(*it, edges);
+        }
+        for (VertexId vertex = meeting_vertex; vertex != to;) {
+            const EdgeId arc_id = data.backward.prev_arcs[vertex];
+            AppendArcEdges(arc_id, edges);
+            vertex = std::get<1>(GetArc(arc_id));
+        }
+
+        Weight weight = ZERO_WEIGHT;
+        for (const EdgeId edge_id : edges) {
+            weight += graph_.GetEdge(edge_id).weight;
+        }
+        return RouteInfo{ weight, std::move(edges) };
+    }
+
+}  // namespace graph
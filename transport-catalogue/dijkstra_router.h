@@ -0,0 +1,301 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+    // Сколько поисков выполнено и сколько вершин в них извлечено из очереди и раскрыто
+    struct SearchStats {
+        size_t searches = 0;
+        size_t settled_vertices = 0;
+    };
+
+    // Поиск маршрута во время запроса (алгоритм Дейкстры) без таблицы всех пар вершин.
+    // Поиск прекращается, как только целевая вершина извлечена из очереди.
+    // С нижней оценкой оставшегося пути lower_bound поиск маршрута идет по A*: очередь
+    // упорядочена по весу плюс оценке. Оценка должна быть допустимой (не больше веса
+    // кратчайшего пути до цели), вершина раскрывается повторно, если путь до нее улучшился
+    template <typename Weight>
+    class DijkstraRouter {
+
+    private:
+
+        using Graph = DirectedWeightedGraph<Weight>;
+
+    public:
+
+        using RouteInfo = graph::RouteInfo<Weight>;
+
+        using LowerBound = std::function<Weight(VertexId vertex, VertexId target)>;
+
+        explicit DijkstraRouter(const Graph& graph, LowerBound lower_bound = nullptr);
+
+        std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+        // Веса маршрутов из from во все вершины targets одним поиском,
+        // поиск прекращается, как только извлечены все целевые вершины
+        std::vector<std::optional<Weight>> GetRouteWeights(VertexId from, const std::vector<VertexId>& targets) const;
+        // Строка таблицы маршрутов из from полным поиском: веса и последние ребра маршрутов
+        // до всех вершин в формате RoutesTable (NO_ROUTE и NO_EDGE, если маршрута нет)
+        void BuildRoutesRow(VertexId from, std::vector<Weight>& weights, std::vector<uint32_t>& prev_edges) const;
+        // Вершины, достижимые из from с весом не больше max_weight, и их веса по возрастанию веса.
+        // Раскрываются только эти вершины, поиск прекращается на первой вершине тяжелее max_weight
+        std::vector<std::pair<VertexId, Weight>> GetReachableVertices(VertexId from, Weight max_weight) const;
+        // Счетчики поисков BuildRoute, BuildRoutesRow и GetReachableVertices
+        SearchStats GetSearchStats() const;
+
+    private:
+
+        // Рабочие буферы поиска. Заводятся один раз на поток и переиспользуются между запросами:
+        // вместо очистки массивов на каждый запрос увеличивается номер поиска (epoch)
+        struct SearchData {
+            std::vector<Weight> weights;
+            std::vector<Weight> lower_bounds;
+            std::vector<EdgeId> prev_edges;
+            std::vector<uint32_t> reached;
+            std::vector<uint32_t> settled;
+            std::vector<uint32_t> targeted;
+            std::vector<std::pair<Weight, VertexId>> queue;
+            uint32_t epoch = 0;
+
+            void Reset(size_t vertex_count) {
+                if (weights.size() != vertex_count) {
+                    weights.assign(vertex_count, ZERO_WEIGHT);
+                    lower_bounds.assign(vertex_count, ZERO_WEIGHT);
+                    prev_edges.assign(vertex_count, 0);
+                    reached.assign(vertex_count, 0);
+                    settled.assign(vertex_count, 0);
+                    targeted.assign(vertex_count, 0);
+                    epoch = 0;
+                }
+                if (++epoch == 0) {
+                    std::fill(reached.begin(), reached.end(), 0);
+                    std::fill(settled.begin(), settled.end(), 0);
+                    std::fill(targeted.begin(), targeted.end(), 0);
+                    epoch = 1;
+                }
+                queue.clear();
+            }
+        };
+
+        static SearchData& GetSearchData() {
+            static thread_local SearchData search_data;
+            return search_data;
+        }
+
+        // Поиск из from до тех пор, пока is_finished не вернет true для раскрываемой вершины.
+        // get_lower_bound - оценка пути от вершины до цели, считается один раз при достижении вершины.
+        // Возвращает число раскрытых вершин
+        template <typename IsFinished, typename GetLowerBound>
+        size_t Search(SearchData& data, VertexId from, IsFinished is_finished, GetLowerBound get_lower_bound) const;
+
+        static constexpr Weight ZERO_WEIGHT{};
+        const Graph& graph_;
+        LowerBound lower_bound_;
+        mutable std::atomic<size_t> searches_ = 0;
+        mutable std::atomic<size_t> settled_vertices_ = 0;
+    };
+
+    template <typename Weight>
+    DijkstraRouter<Weight>::DijkstraRouter(const Graph& graph, LowerBound lower_bound)
+        : graph_(graph)
+        , lower_bound_(std::move(lower_bound))
+    {
+        const size_t edge_count = graph.GetEdgeCount();
+        for (EdgeId edge_id = 0; edge_id < edge_count; ++edge_id) {
+            if (graph.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+        }
+    }
+
+    template <typename Weight>
+    std::optional<typename DijkstraRouter<Weight>::RouteInfo> DijkstraRouter<Weight>::BuildRoute(VertexId from,
+        VertexId to) const {
+        const size_t vertex_count = graph_.GetVertexCount();
+        if (from >= vertex_count || to >= vertex_count) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+
+        SearchData& data = GetSearchData();
+        data.Reset(vertex_count);
+        const uint32_t epoch = data.epoch;
+        auto is_target = [to](VertexId vertex) { return vertex == to; };
+        size_t settled_count = 0;
+        if (lower_bound_) {
+            settled_count = Search(data, from, is_target,
+                [this, to](VertexId vertex) { return lower_bound_(vertex, to); });
+        }
+        else {
+            settled_count = Search(data, from, is_target, [](VertexId) { return ZERO_WEIGHT; });
+        }
+        searches_.fetch_add(1, std::memory_order_relaxed);
+        settled_vertices_.fetch_add(settled_count, std::memory_order_relaxed);
+
+        if (data.settled[to] != epoch) {
+            return std::nullopt;
+        }
+
+        std::vector<EdgeId> edges;
+        for (VertexId vertex = to; vertex != from; vertex = graph_.GetEdge(data.prev_edges[vertex]).from) {
+            edges.push_back(data.prev_edges[vertex]);
+        }
+        std::reverse(edges.begin(), edges.end());
+
+        return RouteInfo{ data.weights[to], std::move(edges) };
+    }
+
+    template <typename Weight>
+    std::vector<std::optional<Weight>> DijkstraRouter<Weight>::GetRouteWeights(VertexId from,
+        const std::vector<VertexId>& targets) const {
+        const size_t vertex_count = graph_.GetVertexCount();
+        if (from >= vertex_count) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+
+        SearchData& data = GetSearchData();
+        data.Reset(vertex_count);
+        const uint32_t epoch = data.epoch;
+        size_t targets_left = 0;
+        for (const VertexId target : targets) {
+            if (target >= vertex_count) {
+                throw std::out_of_range("Vertex id is out of range");
+            }
+            if (data.targeted[target] != epoch) {
+                data.targeted[target] = epoch;
+                ++targets_left;
+            }
+        }
+        if (targets_left > 0) {
+            Search(data, from, [&data, epoch, &targets_left](VertexId vertex) {
+                return data.targeted[vertex] == epoch && --targets_left == 0;
+                }, [](VertexId) { return ZERO_WEIGHT; });
+        }
+
+        std::vector<std::optional<Weight>> result(targets.size());
+        for (size_t i = 0; i < targets.size(); ++i) {
+            if (data.settled[targets[i]] == epoch) {
+                result[i] = data.weights[targets[i]];
+            }
+        }
+        return result;
+    }
+
+    template <typename Weight>
+    void DijkstraRouter<Weight>::BuildRoutesRow(VertexId from, std::vector<Weight>& weights,
+        std::vector<uint32_t>& prev_edges) const {
+        using Table = RoutesTable<Weight>;
+        const size_t vertex_count = graph_.GetVertexCount();
+        if (from >= vertex_count) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+        if (graph_.GetEdgeCount() >= Table::NO_EDGE) {
+            throw std::length_error("Too many edges for routes table");
+        }
+
+        SearchData& data = GetSearchData();
+        data.Reset(vertex_count);
+        const uint32_t epoch = data.epoch;
+        const size_t settled_count = Search(data, from, [](VertexId) { return false; },
+            [](VertexId) { return ZERO_WEIGHT; });
+        searches_.fetch_add(1, std::memory_order_relaxed);
+        settled_vertices_.fetch_add(settled_count, std::memory_order_relaxed);
+
+        weights.assign(vertex_count, Table::NO_ROUTE);
+        prev_edges.assign(vertex_count, Table::NO_EDGE);
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            if (data.settled[vertex] != epoch) {
+                continue;
+            }
+            weights[vertex] = data.weights[vertex];
+            if (vertex != from) {
+                prev_edges[vertex] = static_cast<uint32_t>(data.prev_edges[vertex]);
+            }
+        }
+    }
+
+    template <typename Weight>
+    std::vector<std::pair<VertexId, Weight>> DijkstraRouter<Weight>::GetReachableVertices(VertexId from,
+        Weight max_weight) const {
+        const size_t vertex_count = graph_.GetVertexCount();
+        if (from >= vertex_count) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+
+        SearchData& data = GetSearchData();
+        data.Reset(vertex_count);
+        std::vector<std::pair<VertexId, Weight>> result;
+        const size_t settled_count = Search(data, from, [&data, &result, max_weight](VertexId vertex) {
+            if (max_weight < data.weights[vertex]) {
+                return true;
+            }
+            result.push_back({ vertex, data.weights[vertex] });
+            return false;
+            }, [](VertexId) { return ZERO_WEIGHT; });
+        searches_.fetch_add(1, std::memory_order_relaxed);
+        settled_vertices_.fetch_add(settled_count, std::memory_order_relaxed);
+
+        return result;
+    }
+
+    template <typename Weight>
+    SearchStats DijkstraRouter<Weight>::GetSearchStats() const {
+        return { searches_.load(std::memory_order_relaxed), settled_vertices_.load(std::memory_order_relaxed) };
+    }
+
+    template <typename Weight>
+    template <typename IsFinished, typename GetLowerBound>
+    size_t DijkstraRouter<Weight>::Search(SearchData& data, VertexId from, IsFinished is_finished,
+        GetLowerBound get_lower_bound) const {
+        const uint32_t epoch = data.epoch;
+        const auto queue_order = std::greater<std::pair<Weight, VertexId>>{};
+        size_t settled_count = 0;
+
+        data.weights[from] = ZERO_WEIGHT;
+        data.lower_bounds[from] = get_lower_bound(from);
+        data.reached[from] = epoch;
+        data.queue.push_back({ data.lower_bounds[from], from });
+
+        while (!data.queue.empty()) {
+            std::pop_heap(data.queue.begin(), data.queue.end(), queue_order);
+            const auto [key, vertex] = data.queue.back();
+            data.queue.pop_back();
+            // Устаревшая запись: путь до вершины с тех пор улучшился
+            const Weight weight = data.weights[vertex];
+            if (key > weight + data.lower_bounds[vertex]) {
+                continue;
+            }
+            data.settled[vertex] = epoch;
+            ++settled_count;
+            if (is_finished(vertex)) {
+                break;
+            }
+            for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+                const auto& edge = graph_.GetEdge(edge_id);
+                const Weight candidate_weight = weight + edge.weight;
+                if (data.reached[edge.to] != epoch) {
+                    data.reached[edge.to] = epoch;
+                    data.lower_bounds[edge.to] = get_lower_bound(edge.to);
+                }
+                else if (!(candidate_weight < data.weights[edge.to])) {
+                    continue;
+                }
+                data.weights[edge.to] = candidate_weight;
+                data.prev_edges[edge.to] = edge_id;
+                data.queue.push_back({ candidate_weight + data.lower_bounds[edge.to], edge.to });
+                std::push_heap(data.queue.begin(), data.queue.end(), queue_order);
+            }
+        }
+        return settled_count;
+    }
+
+}  // namespace graph
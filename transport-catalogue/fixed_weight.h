@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+namespace graph {
+
+    // Неотрицательный вес в фиксированной точке: целое число 1/Scale долей единицы веса.
+    // Бесконечность - максимальное значение, сумма с ней (и любое переполнение) дает бесконечность.
+    // Сравнения - целочисленные, поэтому результаты не зависят от платформы
+    template <uint32_t Scale>
+    class FixedWeight {
+
+    public:
+
+        static constexpr uint32_t SCALE = Scale;
+        static constexpr uint32_t INFINITE_RAW = std::numeric_limits<uint32_t>::max();
+
+        constexpr FixedWeight() = default;
+        // Округление до ближайшего, значения вне диапазона - бесконечность
+        explicit FixedWeight(double value)
+            : raw_(value < MAX_VALUE ? static_cast<uint32_t>(value * Scale + 0.5) : INFINITE_RAW) {}
+
+        static constexpr FixedWeight FromRaw(uint32_t raw) {
+            FixedWeight result;
+            result.raw_ = raw;
+            return result;
+        }
+
+        constexpr uint32_t GetRaw() const {
+            return raw_;
+        }
+
+        explicit operator double() const {
+            return raw_ == INFINITE_RAW ? std::numeric_limits<double>::infinity() : static_cast<double>(raw_) / Scale;
+        }
+
+        friend constexpr FixedWeight operator+(FixedWeight lhs, FixedWeight rhs) {
+            const uint64_t sum = static_cast<uint64_t>(lhs.raw_) + rhs.raw_;
+            return FromRaw(sum < INFINITE_RAW ? static_cast<uint32_t>(sum) : INFINITE_RAW);
+        }
+
+        constexpr FixedWeight& operator+=(FixedWeight other) {
+            return *this = *this + other;
+        }
+
+        friend constexpr bool operator==(FixedWeight lhs, FixedWeight rhs) {
+            return lhs.raw_ == rhs.raw_;
+        }
+        friend constexpr bool operator!=(FixedWeight lhs, FixedWeight rhs) {
+            return lhs.raw_ != rhs.raw_;
+        }
+        friend constexpr bool operator<(FixedWeight lhs, FixedWeight rhs) {
+            return lhs.raw_ < rhs.raw_;
+        }
+        friend constexpr bool operator>(FixedWeight lhs, FixedWeight rhs) {
+            return lhs.raw_ > rhs.raw_;
+        }
+        friend constexpr bool operator<=(FixedWeight lhs, FixedWeight rhs) {
+            return lhs.raw_ <= rhs.raw_;
+        }
+        friend constexpr bool operator>=(FixedWeight lhs, FixedWeight rhs) {
+            return lhs.raw_ >= rhs.raw_;
+        }
+
+    private:
+
+        static constexpr double MAX_VALUE = static_cast<double>(INFINITE_RAW - 1) / Scale;
+        uint32_t raw_ = 0;
+    };
+
+    // Время в минутах с точностью до миллисекунды, до 49 суток
+    using FixedTime = FixedWeight<60000>;
+
+    // Масштаб весов фиксированной точки, 0 - вес с плавающей точкой
+    template <typename Weight>
+    struct WeightScale {
+        static constexpr uint32_t value = 0;
+    };
+
+    template <uint32_t Scale>
+    struct WeightScale<FixedWeight<Scale>> {
+        static constexpr uint32_t value = Scale;
+    };
+
+} // namespace graph
+
+namespace std {
+
+    template <uint32_t Scale>
+    class numeric_limits<graph::FixedWeight<Scale>> {
+
+    public:
+
+        static constexpr bool is_specialized = true;
+        static constexpr bool is_signed = false;
+        static constexpr bool is_integer = false;
+        static constexpr bool is_exact = true;
+        static constexpr bool has_infinity = true;
+
+        static constexpr graph::FixedWeight<Scale> min() {
+            return graph::FixedWeight<Scale>::FromRaw(0);
+        }
+        static constexpr graph::FixedWeight<Scale> lowest() {
+            return min();
+        }
+        static constexpr graph::FixedWeight<Scale> max() {
+            return graph::FixedWeight<Scale>::FromRaw(graph::FixedWeight<Scale>::INFINITE_RAW - 1);
+        }
+        static constexpr graph::FixedWeight<Scale> infinity() {
+            return graph::FixedWeight<Scale>::FromRaw(graph::FixedWeight<Scale>::INFINITE_RAW);
+        }
+    };
+
+} // namespace std
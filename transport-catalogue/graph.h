@@ -1,9 +1,12 @@
 #pragma once
 
+#include "page_allocator.h"
 #include "ranges.h"
 
 #include <utility>
+#include <cstdint>
 #include <cstdlib>
+#include <stdexcept>
 #include <vector>
 #include <string>
 #include <string_view>
@@ -13,64 +16,148 @@ namespace graph {
     using VertexId = size_t;
     using EdgeId = size_t;
 
+    // name_id - номер названия (остановки или автобуса) в таблице названий владельца графа.
+    // Поля 32-битные, чтобы ребро было компактным в памяти и в файле базы
     template <typename Weight>
     struct Edge {
-        std::string name;
-        size_t quality;
-        VertexId from;
-        VertexId to;
+        uint32_t name_id;
+        uint32_t quality;
+        uint32_t from;
+        uint32_t to;
         Weight weight;
     };
 
+    // Граф строится добавлением ребер, затем замораживается (Freeze): списки исходящих и входящих
+    // ребер вершин хранятся в сжатом виде (CSR) - смещения вершин и общий массив номеров ребер.
+    // Списки ребер доступны только после заморозки, ребра в них идут в порядке добавления
     template <typename Weight>
     class DirectedWeightedGraph {
 
     private:
 
-        using IncidenceList = std::vector<EdgeId>;
-        using IncidentEdgesRange = ranges::Range<typename IncidenceList::const_iterator>;
+        using IncidentEdgesRange = ranges::Range<typename std::vector<EdgeId>::const_iterator>;
+
+        struct IncidenceLists {
+            std::vector<size_t> offsets;
+            std::vector<EdgeId> edge_ids;
+        };
 
     public:
 
+        using Edges = std::vector<Edge<Weight>, storage::PageAllocator<Edge<Weight>>>;
+
         DirectedWeightedGraph() = default;
         explicit DirectedWeightedGraph(size_t vertex_count);
-        explicit DirectedWeightedGraph(std::vector<Edge<Weight>> edges,
-            std::vector<std::vector<EdgeId>> incidence_lists);
+        // Уже замороженный граф из готовых ребер
+        DirectedWeightedGraph(size_t vertex_count, Edges edges);
         EdgeId AddEdge(Edge<Weight>&& edge);
+        void Freeze();
+        bool IsFrozen() const;
+        // Перенос массива ребер в память со страницами page_mode (без копирования, если режим тот же)
+        void SetPageMode(storage::PageMode page_mode);
+        // Новый вес ребра; роутеры, построенные по графу, после этого нужно обновить
+        void SetEdgeWeight(EdgeId edge_id, Weight weight);
         size_t GetVertexCount() const;
         size_t GetEdgeCount() const;
         const Edge<Weight>& GetEdge(EdgeId edge_id) const;
+        // Все ребра подряд в порядке номеров - для записи в файл базы
+        const Edges& GetEdges() const;
         IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
+        // Ребра, входящие в вершину, - для поиска в обратную сторону от цели
+        IncidentEdgesRange GetIncomingEdges(VertexId vertex) const;
 
     private:
 
-        std::vector<Edge<Weight>> edges_;
-        std::vector<IncidenceList> incidence_lists_;
+        // Номера ребер, сгруппированные по вершине get_vertex(edge), сортировкой подсчетом
+        template <typename GetVertex>
+        IncidenceLists BuildIncidenceLists(GetVertex get_vertex) const;
+        IncidentEdgesRange GetEdgesRange(const IncidenceLists& lists, VertexId vertex) const;
+
+        size_t vertex_count_ = 0;
+        Edges edges_;
+        bool is_frozen_ = false;
+        IncidenceLists incidence_lists_;
+        IncidenceLists reverse_incidence_lists_;
     };
 
     template <typename Weight>
     DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count)
-        : incidence_lists_(vertex_count) {
-        edges_.reserve(vertex_count * vertex_count);
-    }
+        : vertex_count_(vertex_count) {}
 
     template <typename Weight>
-    DirectedWeightedGraph<Weight>::DirectedWeightedGraph(std::vector<Edge<Weight>> edges,
-        std::vector<std::vector<EdgeId>> incidence_lists)
-        : edges_(edges)
-        , incidence_lists_(incidence_lists) {}
+    DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count, Edges edges)
+        : vertex_count_(vertex_count)
+        , edges_(std::move(edges)) {
+        Freeze();
+    }
 
     template <typename Weight>
     EdgeId DirectedWeightedGraph<Weight>::AddEdge(Edge<Weight>&& edge) {
+        if (is_frozen_) {
+            throw std::logic_error("Graph is frozen");
+        }
+        if (edge.from >= vertex_count_ || edge.to >= vertex_count_) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
         edges_.push_back(std::move(edge));
-        const EdgeId id = edges_.size() - 1;
-        incidence_lists_.at(edges_.back().from).push_back(id);
-        return id;
+        return edges_.size() - 1;
+    }
+
+    template <typename Weight>
+    template <typename GetVertex>
+    typename DirectedWeightedGraph<Weight>::IncidenceLists
+        DirectedWeightedGraph<Weight>::BuildIncidenceLists(GetVertex get_vertex) const {
+        IncidenceLists result;
+        result.offsets.assign(vertex_count_ + 1, 0);
+        for (const Edge<Weight>& edge : edges_) {
+            const VertexId vertex = get_vertex(edge);
+            if (vertex >= vertex_count_) {
+                throw std::out_of_range("Vertex id is out of range");
+            }
+            ++result.offsets[vertex + 1];
+        }
+        for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+            result.offsets[vertex + 1] += result.offsets[vertex];
+        }
+        result.edge_ids.resize(edges_.size());
+        std::vector<size_t> positions(result.offsets.begin(), result.offsets.end() - 1);
+        for (EdgeId edge_id = 0; edge_id < edges_.size(); ++edge_id) {
+            result.edge_ids[positions[get_vertex(edges_[edge_id])]++] = edge_id;
+        }
+        return result;
+    }
+
+    template <typename Weight>
+    void DirectedWeightedGraph<Weight>::Freeze() {
+        if (is_frozen_) {
+            return;
+        }
+        edges_.shrink_to_fit();
+        incidence_lists_ = BuildIncidenceLists([](const Edge<Weight>& edge) { return edge.from; });
+        reverse_incidence_lists_ = BuildIncidenceLists([](const Edge<Weight>& edge) { return edge.to; });
+        is_frozen_ = true;
+    }
+
+    template <typename Weight>
+    bool DirectedWeightedGraph<Weight>::IsFrozen() const {
+        return is_frozen_;
+    }
+
+    template <typename Weight>
+    void DirectedWeightedGraph<Weight>::SetPageMode(storage::PageMode page_mode) {
+        if (edges_.get_allocator().GetMode() != page_mode) {
+            edges_ = Edges(edges_.begin(), edges_.end(), storage::PageAllocator<Edge<Weight>>(page_mode));
+        }
+    }
+
+    template <typename Weight>
+    void DirectedWeightedGraph<Weight>::SetEdgeWeight(EdgeId edge_id, Weight weight) {
+        edges_.at(edge_id).weight = weight;
     }
 
     template <typename Weight>
     size_t DirectedWeightedGraph<Weight>::GetVertexCount() const {
-        return incidence_lists_.size();
+        return vertex_count_;
     }
 
     template <typename Weight>
@@ -83,10 +170,34 @@ namespace graph {
         return edges_.at(edge_id);
     }
 
+    template <typename Weight>
+    const typename DirectedWeightedGraph<Weight>::Edges& DirectedWeightedGraph<Weight>::GetEdges() const {
+        return edges_;
+    }
+
+    template <typename Weight>
+    typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
+        DirectedWeightedGraph<Weight>::GetEdgesRange(const IncidenceLists& lists, VertexId vertex) const {
+        if (!is_frozen_) {
+            throw std::logic_error("Graph is not frozen");
+        }
+        if (vertex >= vertex_count_) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+        return ranges::Range{ lists.edge_ids.begin() + lists.offsets[vertex],
+            lists.edge_ids.begin() + lists.offsets[vertex + 1] };
+    }
+
     template <typename Weight>
     typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
         DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
-        return ranges::AsRange(incidence_lists_.at(vertex));
+        return GetEdgesRange(incidence_lists_, vertex);
+    }
+
+    template <typename Weight>
+    typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
+        DirectedWeightedGraph<Weight>::GetIncomingEdges(VertexId vertex) const {
+        return GetEdgesRange(reverse_incidence_lists_, vertex);
     }
 
-} 
+}
\ No newline at end of file
@@ -0,0 +1,347 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+    // Метка вершины: хаб (номер в порядке важности), вес пути между вершиной и хабом
+    // и ребро этого пути у вершины (NO_EDGE - вершина сама хаб)
+    template <typename Weight>
+    struct HubLabel {
+        static constexpr uint32_t NO_EDGE = std::numeric_limits<uint32_t>::max();
+
+        uint32_t hub;
+        uint32_t edge;
+        Weight weight;
+    };
+
+    // Метки хабов всех вершин: out - пути из вершины в хаб, in - из хаба в вершину.
+    // Метки вершины v - [offsets[v], offsets[v + 1]), по возрастанию номера хаба.
+    // hubs - вершины хабов по номерам, в этом порядке метки строятся заново после изменения весов
+    template <typename Weight>
+    struct HubLabels {
+        std::vector<VertexId> hubs;
+        std::vector<uint64_t> out_offsets;
+        std::vector<HubLabel<Weight>> out_labels;
+        std::vector<uint64_t> in_offsets;
+        std::vector<HubLabel<Weight>> in_labels;
+    };
+
+    // Поиск по меткам хабов (pruned landmark labeling): кратчайший путь из from в to проходит через
+    // общий хаб out-меток from и in-меток to, поэтому вес маршрута - слияние двух коротких
+    // отсортированных массивов без поиска по графу. Метки строятся поисками Дейкстры из хабов
+    // по убыванию важности, вершины, пути до которых уже покрыты прежними хабами, отсекаются.
+    // Ребро метки ведет к соседу по дереву поиска из хаба, у которого есть метка того же хаба,
+    // поэтому маршрут разворачивается по меткам
+    template <typename Weight>
+    class HubLabelRouter {
+
+    private:
+
+        using Graph = DirectedWeightedGraph<Weight>;
+        using Label = HubLabel<Weight>;
+        using Labels = HubLabels<Weight>;
+
+    public:
+
+        using RouteInfo = graph::RouteInfo<Weight>;
+
+        // Предобработка графа (выполняется при make_base): ranks - важность вершин,
+        // например ранги иерархии сокращений, первыми хабами становятся вершины с большим рангом
+        HubLabelRouter(const Graph& graph, const std::vector<uint32_t>& ranks);
+        // Восстановление ранее рассчитанных меток
+        HubLabelRouter(const Graph& graph, Labels labels);
+
+        // Метки заново после изменения весов ребер графа, порядок хабов прежний
+        void UpdateLabels();
+
+        std::optional<Weight> GetRouteWeight(VertexId from, VertexId to) const;
+        std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+        const Labels& GetLabels() const;
+
+    private:
+
+        // Лучший общий хаб: номер хаба и вес маршрута через него
+        std::optional<std::pair<uint32_t, Weight>> FindBestHub(VertexId from, VertexId to) const;
+        const Label& FindLabel(const std::vector<uint64_t>& offsets, const std::vector<Label>& labels,
+            VertexId vertex, uint32_t hub) const;
+        void BuildLabels();
+
+        static constexpr Weight ZERO_WEIGHT{};
+        const Graph& graph_;
+        Labels labels_;
+    };
+
+    template <typename Weight>
+    HubLabelRouter<Weight>::HubLabelRouter(const Graph& graph, const std::vector<uint32_t>& ranks)
+        : graph_(graph)
+    {
+        if (ranks.size() != graph.GetVertexCount()) {
+            throw std::invalid_argument("Vertex ranks don't match the graph");
+        }
+        if (graph.GetEdgeCount() >= Label::NO_EDGE) {
+            throw std::length_error("Too many edges for hub labels");
+        }
+        labels_.hubs.resize(ranks.size());
+        for (VertexId vertex = 0; vertex < ranks.size(); ++vertex) {
+            labels_.hubs[vertex] = vertex;
+        }
+        std::stable_sort(labels_.hubs.begin(), labels_.hubs.end(),
+            [&ranks](VertexId lhs, VertexId rhs) { return ranks[lhs] > ranks[rhs]; });
+        BuildLabels();
+    }
+
+    template <typename Weight>
+    HubLabelRouter<Weight>::HubLabelRouter(const Graph& graph, Labels labels)
+        : graph_(graph)
+        , labels_(std::move(labels))
+    {
+        const size_t vertex_count = graph.GetVertexCount();
+        if (labels_.hubs.size() != vertex_count) {
+            throw std::invalid_argument("Hub labels don't match the graph");
+        }
+        std::vector<char> is_hub(vertex_count, false);
+        for (const VertexId hub : labels_.hubs) {
+            if (hub >= vertex_count || is_hub[hub]) {
+                throw std::invalid_argument("Hub labels don't match the graph");
+            }
+            is_hub[hub] = true;
+        }
+        for (auto [offsets, labels_ptr] : { std::pair{ &labels_.out_offsets, &labels_.out_labels },
+            std::pair{ &labels_.in_offsets, &labels_.in_labels } }) {
+            if (offsets->size() != vertex_count + 1 || offsets->front() != 0
+                || offsets->back() != labels_ptr->size() || !std::is_sorted(offsets->begin(), offsets->end())) {
+                throw std::invalid_argument("Hub labels don't match the graph");
+            }
+            for (const Label& label : *labels_ptr) {
+                if (label.hub >= vertex_count || (label.edge != Label::NO_EDGE && label.edge >= graph.GetEdgeCount())) {
+                    throw std::invalid_argument("Hub labels refer to unknown edge");
+                }
+            }
+        }
+    }
+
+    template <typename Weight>
+    void HubLabelRouter<Weight>::UpdateLabels() {
+        labels_.out_offsets.clear();
+        labels_.out_labels.clear();
+        labels_.in_offsets.clear();
+        labels_.in_labels.clear();
+        BuildLabels();
+    }
+
+    template <typename Weight>
+    void HubLabelRouter<Weight>::BuildLabels() {
+        const size_t vertex_count = graph_.GetVertexCount();
+        for (EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+            if (graph_.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+        }
+        const std::vector<VertexId>& hubs = labels_.hubs;
+        std::vector<std::vector<Label>> out_labels(vertex_count);
+        std::vector<std::vector<Label>> in_labels(vertex_count);
+        // Веса меток текущего хаба по номеру хаба метки для быстрой проверки покрытия
+        std::vector<Weight> hub_weights(vertex_count, std::numeric_limits<Weight>::infinity());
+        std::vector<Weight> weights(vertex_count);
+        std::vector<uint32_t> edges(vertex_count);
+        std::vector<char> is_reached(vertex_count, false);
+        std::vector<char> is_settled(vertex_count, false);
+        std::vector<VertexId> touched;
+        std::vector<std::pair<Weight, VertexId>> queue;
+        const auto queue_order = std::greater<std::pair<Weight, VertexId>>{};
+
+        // Поиск из хаба по исходящим (is_forward) или входящим ребрам, найденные вершины получают метки
+        // в labels, если путь до них не покрыт метками hub_labels хаба и их собственными метками
+        auto run_search = [&](uint32_t hub_index, bool is_forward, const std::vector<Label>& hub_labels,
+            std::vector<std::vector<Label>>& labels) {
+            const VertexId hub = hubs[hub_index];
+            for (const Label& label : hub_labels) {
+                hub_weights[label.hub] = label.weight;
+            }
+            weights[hub] = ZERO_WEIGHT;
+            edges[hub] = Label::NO_EDGE;
+            is_reached[hub] = true;
+            touched.push_back(hub);
+            queue.push_back({ ZERO_WEIGHT, hub });
+            while (!queue.empty()) {
+                std::pop_heap(queue.begin(), queue.end(), queue_order);
+                const auto [weight, vertex] = queue.back();
+                queue.pop_back();
+                if (is_settled[vertex] || weight > weights[vertex]) {
+                    continue;
+                }
+                is_settled[vertex] = true;
+                bool is_covered = false;
+                for (const Label& label : labels[vertex]) {
+                    if (!(hub_weights[label.hub] + label.weight > weight)) {
+                        is_covered = true;
+                        break;
+                    }
+                }
+                if (is_covered) {
+                    continue;
+                }
+                labels[vertex].push_back({ hub_index, edges[vertex], weight });
+
+                const auto incident_edges = is_forward ? graph_.GetIncidentEdges(vertex) : graph_.GetIncomingEdges(vertex);
+                for (const EdgeId edge_id : incident_edges) {
+                    const auto& edge = graph_.GetEdge(edge_id);
+                    const VertexId next_vertex = is_forward ? edge.to : edge.from;
+                    const Weight candidate_weight = weight + edge.weight;
+                    if (!is_reached[next_vertex] || candidate_weight < weights[next_vertex]) {
+                        if (!is_reached[next_vertex]) {
+                            is_reached[next_vertex] = true;
+                            touched.push_back(next_vertex);
+                        }
+                        weights[next_vertex] = candidate_weight;
+                        edges[next_vertex] = static_cast<uint32_t>(edge_id);
+                        queue.push_back({ candidate_weight, next_vertex });
+                        std::push_heap(queue.begin(), queue.end(), queue_order);
+                    }
+                }
+            }
+            for (const VertexId vertex : touched) {
+                is_reached[vertex] = false;
+                is_settled[vertex] = false;
+            }
+            touched.clear();
+            for (const Label& label : hub_labels) {
+                hub_weights[label.hub] = std::numeric_limits<Weight>::infinity();
+            }
+        };
+
+        for (uint32_t hub_index = 0; hub_index < vertex_count; ++hub_index) {
+            const VertexId hub = hubs[hub_index];
+            // Путь из хаба в вершину покрыт, если через прежний хаб из out-меток хаба он не длиннее
+            run_search(hub_index, true, out_labels[hub], in_labels);
+            run_search(hub_index, false, in_labels[hub], out_labels);
+        }
+
+        for (auto [offsets, flat_labels, vertex_labels] : {
+            std::tuple{ &labels_.out_offsets, &labels_.out_labels, &out_labels },
+            std::tuple{ &labels_.in_offsets, &labels_.in_labels, &in_labels } }) {
+            offsets->reserve(vertex_count + 1);
+            offsets->push_back(0);
+            for (const auto& labels : *vertex_labels) {
+                offsets->push_back(offsets->back() + labels.size());
+            }
+            flat_labels->reserve(offsets->back());
+            for (auto& labels : *vertex_labels) {
+                flat_labels->insert(flat_labels->end(), labels.begin(), labels.end());
+                labels = {};
+            }
+        }
+    }
+
+    template <typename Weight>
+    std::optional<std::pair<uint32_t, Weight>> HubLabelRouter<Weight>::FindBestHub(VertexId from, VertexId to) const {
+        const size_t vertex_count = graph_.GetVertexCount();
+        if (from >= vertex_count || to >= vertex_count) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+        const Label* out_it = labels_.out_labels.data() + labels_.out_offsets[from];
+        const Label* out_end = labels_.out_labels.data() + labels_.out_offsets[from + 1];
+        const Label* in_it = labels_.in_labels.data() + labels_.in_offsets[to];
+        const Label* in_end = labels_.in_labels.data() + labels_.in_offsets[to + 1];
+        std::optional<std::pair<uint32_t, Weight>> result;
+        while (out_it != out_end && in_it != in_end) {
+            if (out_it->hub < in_it->hub) {
+                ++out_it;
+            }
+            else if (in_it->hub < out_it->hub) {
+                ++in_it;
+            }
+            else {
+                const Weight weight = out_it->weight + in_it->weight;
+                if (!result || weight < result->second) {
+                    result = { out_it->hub, weight };
+                }
+                ++out_it;
+                ++in_it;
+            }
+        }
+        return result;
+    }
+
+    template <typename Weight>
+    const HubLabel<Weight>& HubLabelRouter<Weight>::FindLabel(const std::vector<uint64_t>& offsets,
+        const std::vector<Label>& labels, VertexId vertex, uint32_t hub) const {
+        const auto begin = labels.begin() + offsets[vertex];
+        const auto end = labels.begin() + offsets[vertex + 1];
+        const auto it = std::lower_bound(begin, end, hub,
+            [](const Label& label, uint32_t value) { return label.hub < value; });
+        if (it == end || it->hub != hub) {
+            throw std::invalid_argument("Hub labels are inconsistent");
+        }
+        return *it;
+    }
+
+    template <typename Weight>
+    std::optional<Weight> HubLabelRouter<Weight>::GetRouteWeight(VertexId from, VertexId to) const {
+        if (from == to) {
+            return ZERO_WEIGHT;
+        }
+        if (const auto best_hub = FindBestHub(from, to)) {
+            return best_hub->second;
+        }
+        return std::nullopt;
+    }
+
+    template <typename Weight>
+    std::optional<typename HubLabelRouter<Weight>::RouteInfo>
+        HubLabelRouter<Weight>::BuildRoute(VertexId from, VertexId to) const {
+        if (from == to) {
+            return RouteInfo{ ZERO_WEIGHT, {} };
+        }
+        const auto best_hub = FindBestHub(from, to);
+        if (!best_hub) {
+            return std::nullopt;
+        }
+        const uint32_t hub = best_hub->first;
+
+        // Из from в хаб - по out-меткам вперед, из хаба в to - по in-меткам назад
+        std::vector<EdgeId> edges;
+        for (VertexId vertex = from;;) {
+            const Label& label = FindLabel(labels_.out_offsets, labels_.out_labels, vertex, hub);
+            if (label.edge == Label::NO_EDGE) {
+                break;
+            }
+            edges.push_back(label.edge);
+            vertex = graph_.GetEdge(label.edge).to;
+        }
+        const size_t hub_position = edges.size();
+        for (VertexId vertex = to;;) {
+            const Label& label = FindLabel(labels_.in_offsets, labels_.in_labels, vertex, hub);
+            if (label.edge == Label::NO_EDGE) {
+                break;
+            }
+            edges.push_back(label.edge);
+            vertex = graph_.GetEdge(label.edge).from;
+        }
+        std::reverse(edges.begin() + hub_position, edges.end());
+
+        Weight weight = ZERO_WEIGHT;
+        for (const EdgeId edge_id : edges) {
+            weight += graph_.GetEdge(edge_id).weight;
+        }
+        return RouteInfo{ weight, std::move(edges) };
+    }
+
+    template <typename Weight>
+    const HubLabels<Weight>& HubLabelRouter<Weight>::GetLabels() const {
+        return labels_;
+    }
+
+}  // namespace graph
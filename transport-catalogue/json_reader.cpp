@@ -39,6 +39,15 @@ const json::Node& JsonReader::GetRoutingSettings() const {
     }
 }
 
+const json::Node& JsonReader::GetRoutingUpdates() const {
+    if (!input_.GetRoot().AsDict().count("routing_updates"s)) {
+        return dummy_;
+    }
+    else {
+        return input_.GetRoot().AsDict().at("routing_updates"s);
+    }
+}
+
 
 const json::Node& JsonReader::GetSerializationSettings() const {
     if (!input_.GetRoot().AsDict().count("serialization_settings"s)) {
@@ -19,6 +19,8 @@ public:
     const json::Node& GetStatRequest() const;
     const json::Node& GetRenderSettings() const;
     const json::Node& GetRoutingSettings() const;
+    // Изменения времени ожидания и скорости автобусов для process_requests
+    const json::Node& GetRoutingUpdates() const;
     const json::Node& GetSerializationSettings() const;
     void FillCatalogue(transport::Catalogue& catalogue) const;
 
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "dijkstra_router.h"
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+    // Таблица маршрутов, строки которой считаются по требованию: первый запрос из вершины
+    // строит ее строку полным поиском Дейкстры, следующие запросы из нее читают сохраненную строку.
+    // Стоимость запуска - только по реально использованным вершинам отправления
+    template <typename Weight>
+    class LazyRouter {
+
+    private:
+
+        using Graph = DirectedWeightedGraph<Weight>;
+        using Table = RoutesTable<Weight>;
+
+    public:
+
+        using RouteInfo = graph::RouteInfo<Weight>;
+
+        explicit LazyRouter(const Graph& graph);
+
+        std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+        std::optional<Weight> GetRouteWeight(VertexId from, VertexId to) const;
+        SearchStats GetSearchStats() const;
+        // Сброс строк, затронутых сменой весов ребер графа (old_weights - прежние веса),
+        // они будут построены заново при следующем запросе. Возвращает число сброшенных строк.
+        // Не должен выполняться одновременно с запросами
+        size_t RepairRoutes(const std::vector<std::pair<EdgeId, Weight>>& old_weights);
+
+    private:
+
+        struct Row {
+            std::vector<Weight> weights;
+            std::vector<uint32_t> prev_edges;
+        };
+
+        // Строка из вершины from, при необходимости построенная. Поиск идет вне блокировки:
+        // если строку одновременно построили два потока, сохраняется первая
+        const Row& GetRow(VertexId from) const;
+
+        const Graph& graph_;
+        DijkstraRouter<Weight> dijkstra_router_;
+        mutable std::mutex rows_mutex_;
+        mutable std::vector<std::unique_ptr<const Row>> rows_;
+    };
+
+    template <typename Weight>
+    LazyRouter<Weight>::LazyRouter(const Graph& graph)
+        : graph_(graph)
+        , dijkstra_router_(graph)
+        , rows_(graph.GetVertexCount()) {}
+
+    template <typename Weight>
+    const typename LazyRouter<Weight>::Row& LazyRouter<Weight>::GetRow(VertexId from) const {
+        if (from >= rows_.size()) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+        {
+            std::lock_guard lock(rows_mutex_);
+            if (rows_[from]) {
+                return *rows_[from];
+            }
+        }
+
+        auto row = std::make_unique<Row>();
+        dijkstra_router_.BuildRoutesRow(from, row->weights, row->prev_edges);
+
+        std::lock_guard lock(rows_mutex_);
+        if (!rows_[from]) {
+            rows_[from] = std::move(row);
+        }
+        return *rows_[from];
+    }
+
+    template <typename Weight>
+    std::optional<typename LazyRouter<Weight>::RouteInfo> LazyRouter<Weight>::BuildRoute(VertexId from,
+        VertexId to) const {
+        if (to >= graph_.GetVertexCount()) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+        const Row& row = GetRow(from);
+        if (row.weights[to] == Table::NO_ROUTE) {
+            return std::nullopt;
+        }
+
+        std::vector<EdgeId> edges;
+        for (uint32_t edge_id = row.prev_edges[to];
+            edge_id != Table::NO_EDGE;
+            edge_id = row.prev_edges[graph_.GetEdge(edge_id).from])
+        {
+            edges.push_back(edge_id);
+        }
+        std::reverse(edges.begin(), edges.end());
+
+        return RouteInfo{ row.weights[to], std::move(edges) };
+    }
+
+    template <typename Weight>
+    std::optional<Weight> LazyRouter<Weight>::GetRouteWeight(VertexId from, VertexId to) const {
+        if (to >= graph_.GetVertexCount()) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+        const Weight weight = GetRow(from).weights[to];
+        if (weight == Table::NO_ROUTE) {
+            return std::nullopt;
+        }
+        return weight;
+    }
+
+    template <typename Weight>
+    size_t LazyRouter<Weight>::RepairRoutes(const std::vector<std::pair<EdgeId, Weight>>& old_weights) {
+        const size_t vertex_count = graph_.GetVertexCount();
+        const EdgeWeightChanges<Weight> changes(graph_, old_weights);
+        size_t dropped_count = 0;
+        std::lock_guard lock(rows_mutex_);
+        for (auto& row : rows_) {
+            if (row && changes.IsRowAffected(row->weights.data(), row->prev_edges.data(), vertex_count)) {
+                row.reset();
+                ++dropped_count;
+            }
+        }
+        return dropped_count;
+    }
+
+    template <typename Weight>
+    SearchStats LazyRouter<Weight>::GetSearchStats() const {
+        return dijkstra_router_.GetSearchStats();
+    }
+
+}  // namespace graph
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+
+namespace cache {
+
+    struct CacheStats {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t size = 0;
+        size_t capacity = 0;
+    };
+
+    // Кэш на capacity значений с вытеснением давно не использованных (LRU).
+    // Все методы потокобезопасны, значения возвращаются копией - Value лучше делать дешевым
+    // для копирования (например, shared_ptr)
+    template <typename Key, typename Value, typename Hash = std::hash<Key>>
+    class LruCache {
+
+    public:
+
+        explicit LruCache(size_t capacity)
+            : capacity_(capacity) {
+            positions_.reserve(capacity);
+        }
+
+        std::optional<Value> Get(const Key& key) {
+            std::lock_guard lock(mutex_);
+            auto it = positions_.find(key);
+            if (it == positions_.end()) {
+                ++misses_;
+                return std::nullopt;
+            }
+            ++hits_;
+            items_.splice(items_.begin(), items_, it->second);
+            return it->second->second;
+        }
+
+        void Put(const Key& key, Value value) {
+            if (capacity_ == 0) {
+                return;
+            }
+            std::lock_guard lock(mutex_);
+            auto it = positions_.find(key);
+            if (it != positions_.end()) {
+                it->second->second = std::move(value);
+                items_.splice(items_.begin(), items_, it->second);
+                return;
+            }
+            if (items_.size() == capacity_) {
+                positions_.erase(items_.back().first);
+                items_.pop_back();
+            }
+            items_.emplace_front(key, std::move(value));
+            positions_[key] = items_.begin();
+        }
+
+        // Удаление всех значений, счетчики сохраняются
+        void Clear() {
+            std::lock_guard lock(mutex_);
+            items_.clear();
+            positions_.clear();
+        }
+
+        CacheStats GetStats() const {
+            std::lock_guard lock(mutex_);
+            return { hits_, misses_, items_.size(), capacity_ };
+        }
+
+    private:
+
+        using Items = std::list<std::pair<Key, Value>>;
+
+        mutable std::mutex mutex_;
+        const size_t capacity_;
+        // Начало списка - последние использованные значения
+        Items items_;
+        std::unordered_map<Key, typename Items::iterator, Hash> positions_;
+        size_t hits_ = 0;
+        size_t misses_ = 0;
+    };
+
+} // namespace cache
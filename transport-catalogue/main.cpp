@@ -46,7 +46,9 @@ int main(int argc, char* argv[]) {
         std::ifstream db_file(input_json.GetSerializationSettings().AsDict().at("file"s).AsString(), std::ios::binary);
         if (db_file) {
             auto [tcat, renderer, router, graph, stop_ids] = Deserialize(db_file);
+            router.SetCatalogue(tcat);
             router.SetGraph(std::move(graph), std::move(stop_ids));
+            router.ApplyUpdates(input_json.GetRoutingUpdates());
             RequestHandler handler(tcat, router, renderer);
             handler.JsonStatRequests(input_json.GetStatRequest(), std::cout);
         }
@@ -0,0 +1,169 @@
+#include "mapped_file.h"
+
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace storage {
+
+    namespace {
+
+        [[noreturn]] void ThrowFileError(const string& action, const string& path) {
+            throw runtime_error("Can't "s + action + " file "s + path);
+        }
+
+    } // namespace
+
+#ifdef _WIN32
+
+    MappedFile MappedFile::Open(const std::string& path) {
+        MappedFile result;
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            ThrowFileError("open"s, path);
+        }
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+            CloseHandle(file);
+            ThrowFileError("map"s, path);
+        }
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+        CloseHandle(file);
+        if (!mapping) {
+            ThrowFileError("map"s, path);
+        }
+        void* data = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+        CloseHandle(mapping);
+        if (!data) {
+            ThrowFileError("map"s, path);
+        }
+        result.data_ = static_cast<std::byte*>(data);
+        result.size_ = static_cast<size_t>(file_size.QuadPart);
+        return result;
+    }
+
+    MappedFile MappedFile::Create(const std::string& path, size_t size) {
+        MappedFile result;
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+            FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            ThrowFileError("create"s, path);
+        }
+        const uint64_t mapping_size = size;
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE,
+            static_cast<DWORD>(mapping_size >> 32), static_cast<DWORD>(mapping_size & 0xFFFFFFFFu), nullptr);
+        CloseHandle(file);
+        if (!mapping) {
+            ThrowFileError("map"s, path);
+        }
+        void* data = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size);
+        CloseHandle(mapping);
+        if (!data) {
+            ThrowFileError("map"s, path);
+        }
+        result.data_ = static_cast<std::byte*>(data);
+        result.size_ = size;
+        return result;
+    }
+
+    void MappedFile::Close() noexcept {
+        if (data_) {
+            UnmapViewOfFile(data_);
+        }
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+#else
+
+    MappedFile MappedFile::Open(const std::string& path) {
+        MappedFile result;
+        const int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            ThrowFileError("open"s, path);
+        }
+        struct stat file_stat;
+        if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+            close(fd);
+            ThrowFileError("map"s, path);
+        }
+        const size_t size = static_cast<size_t>(file_stat.st_size);
+        void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) {
+            ThrowFileError("map"s, path);
+        }
+        result.data_ = static_cast<std::byte*>(data);
+        result.size_ = size;
+        return result;
+    }
+
+    MappedFile MappedFile::Create(const std::string& path, size_t size) {
+        MappedFile result;
+        const int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            ThrowFileError("create"s, path);
+        }
+        if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            close(fd);
+            ThrowFileError("resize"s, path);
+        }
+        void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) {
+            ThrowFileError("map"s, path);
+        }
+        result.data_ = static_cast<std::byte*>(data);
+        result.size_ = size;
+        return result;
+    }
+
+    void MappedFile::Close() noexcept {
+        if (data_) {
+            munmap(data_, size_);
+        }
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+#endif
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept
+        : data_(std::exchange(other.data_, nullptr))
+        , size_(std::exchange(other.size_, 0)) {}
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            Close();
+            data_ = std::exchange(other.data_, nullptr);
+            size_ = std::exchange(other.size_, 0);
+        }
+        return *this;
+    }
+
+    MappedFile::~MappedFile() {
+        Close();
+    }
+
+    std::byte* MappedFile::GetData() const {
+        return data_;
+    }
+
+    size_t MappedFile::GetSize() const {
+        return size_;
+    }
+
+} // namespace storage
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace storage {
+
+    // Файл, отображенный в память целиком. Страницы читаются с диска при первом обращении
+    // и разделяются через кэш страниц между процессами, открывшими тот же файл
+    class MappedFile {
+
+    public:
+
+        // Существующий файл. Запись в память допустима, но остается в процессе: измененные
+        // страницы копируются, файл на диске не меняется
+        static MappedFile Open(const std::string& path);
+        // Новый файл размера size (прежний перезаписывается), запись в память попадает в файл
+        static MappedFile Create(const std::string& path, size_t size);
+
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        ~MappedFile();
+
+        std::byte* GetData() const;
+        size_t GetSize() const;
+
+    private:
+
+        MappedFile() = default;
+        void Close() noexcept;
+
+        std::byte* data_ = nullptr;
+        size_t size_ = 0;
+    };
+
+} // namespace storage
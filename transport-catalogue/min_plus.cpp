@@ -0,0 +1,252 @@
+#include "min_plus.h"
+
+#include <limits>
+
+// Векторные реализации собираются только для x86 в GCC и Clang: target-атрибуты позволяют
+// использовать AVX2 без флагов сборки для всего проекта, а выбор делается при запуске
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define TCAT_MIN_PLUS_X86
+#include <immintrin.h>
+#endif
+
+namespace graph {
+
+    namespace {
+
+        template <typename Weight>
+        using RelaxRowFunction = void (*)(Weight*, uint32_t*, const Weight*, const uint32_t*, Weight, size_t);
+
+        enum class Kernel {
+            SCALAR,
+            SSE41,
+            AVX2
+        };
+
+#ifdef TCAT_MIN_PLUS_X86
+
+        // Блоки без улучшений (в конце расчета почти все) не записываются
+        __attribute__((target("avx2")))
+        void RelaxRowAvx2(double* weights, uint32_t* prev_edges, const double* through_weights,
+            const uint32_t* through_prev_edges, double weight_from, size_t count) {
+            const __m256d from = _mm256_set1_pd(weight_from);
+            // Младшие половины 64-битных масок - в младшие 128 бит
+            const __m256i pack_mask = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+            size_t i = 0;
+            for (; i + 4 <= count; i += 4) {
+                const __m256d candidate_weights = _mm256_add_pd(from, _mm256_loadu_pd(through_weights + i));
+                const __m256d current_weights = _mm256_loadu_pd(weights + i);
+                const __m256d is_shorter = _mm256_cmp_pd(candidate_weights, current_weights, _CMP_LT_OQ);
+                if (_mm256_testz_pd(is_shorter, is_shorter)) {
+                    continue;
+                }
+                _mm256_storeu_pd(weights + i, _mm256_blendv_pd(current_weights, candidate_weights, is_shorter));
+                const __m128i edge_mask = _mm256_castsi256_si128(
+                    _mm256_permutevar8x32_epi32(_mm256_castpd_si256(is_shorter), pack_mask));
+                __m128i* prev = reinterpret_cast<__m128i*>(prev_edges + i);
+                const __m128i through_prev = _mm_loadu_si128(reinterpret_cast<const __m128i*>(through_prev_edges + i));
+                _mm_storeu_si128(prev, _mm_blendv_epi8(_mm_loadu_si128(prev), through_prev, edge_mask));
+            }
+            RelaxRowScalar(weights + i, prev_edges + i, through_weights + i, through_prev_edges + i,
+                weight_from, count - i);
+        }
+
+        __attribute__((target("avx2")))
+        void RelaxRowAvx2(float* weights, uint32_t* prev_edges, const float* through_weights,
+            const uint32_t* through_prev_edges, float weight_from, size_t count) {
+            const __m256 from = _mm256_set1_ps(weight_from);
+            size_t i = 0;
+            for (; i + 8 <= count; i += 8) {
+                const __m256 candidate_weights = _mm256_add_ps(from, _mm256_loadu_ps(through_weights + i));
+                const __m256 current_weights = _mm256_loadu_ps(weights + i);
+                const __m256 is_shorter = _mm256_cmp_ps(candidate_weights, current_weights, _CMP_LT_OQ);
+                if (_mm256_testz_ps(is_shorter, is_shorter)) {
+                    continue;
+                }
+                _mm256_storeu_ps(weights + i, _mm256_blendv_ps(current_weights, candidate_weights, is_shorter));
+                __m256i* prev = reinterpret_cast<__m256i*>(prev_edges + i);
+                const __m256i through_prev = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(through_prev_edges + i));
+                _mm256_storeu_si256(prev, _mm256_blendv_epi8(_mm256_loadu_si256(prev), through_prev,
+                    _mm256_castps_si256(is_shorter)));
+            }
+            RelaxRowScalar(weights + i, prev_edges + i, through_weights + i, through_prev_edges + i,
+                weight_from, count - i);
+        }
+
+        // Беззнаковые сравнения через min/max: переполнение суммы - если она меньше слагаемого
+        __attribute__((target("avx2")))
+        void RelaxRowAvx2(uint32_t* weights, uint32_t* prev_edges, const uint32_t* through_weights,
+            const uint32_t* through_prev_edges, uint32_t weight_from, size_t count) {
+            const __m256i from = _mm256_set1_epi32(static_cast<int>(weight_from));
+            size_t i = 0;
+            for (; i + 8 <= count; i += 8) {
+                const __m256i sum = _mm256_add_epi32(from,
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(through_weights + i)));
+                const __m256i is_not_overflow = _mm256_cmpeq_epi32(_mm256_max_epu32(sum, from), sum);
+                const __m256i candidate_weights = _mm256_or_si256(sum,
+                    _mm256_xor_si256(is_not_overflow, _mm256_set1_epi32(-1)));
+                __m256i* current = reinterpret_cast<__m256i*>(weights + i);
+                const __m256i current_weights = _mm256_loadu_si256(current);
+                const __m256i is_shorter = _mm256_andnot_si256(_mm256_cmpeq_epi32(candidate_weights, current_weights),
+                    _mm256_cmpeq_epi32(_mm256_min_epu32(candidate_weights, current_weights), candidate_weights));
+                if (_mm256_testz_si256(is_shorter, is_shorter)) {
+                    continue;
+                }
+                _mm256_storeu_si256(current, _mm256_blendv_epi8(current_weights, candidate_weights, is_shorter));
+                __m256i* prev = reinterpret_cast<__m256i*>(prev_edges + i);
+                const __m256i through_prev = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(through_prev_edges + i));
+                _mm256_storeu_si256(prev, _mm256_blendv_epi8(_mm256_loadu_si256(prev), through_prev, is_shorter));
+            }
+            RelaxRowScalar(weights + i, prev_edges + i, through_weights + i, through_prev_edges + i,
+                weight_from, count - i);
+        }
+
+        __attribute__((target("sse4.1")))
+        void RelaxRowSse41(double* weights, uint32_t* prev_edges, const double* through_weights,
+            const uint32_t* through_prev_edges, double weight_from, size_t count) {
+            const __m128d from = _mm_set1_pd(weight_from);
+            size_t i = 0;
+            for (; i + 2 <= count; i += 2) {
+                const __m128d candidate_weights = _mm_add_pd(from, _mm_loadu_pd(through_weights + i));
+                const __m128d current_weights = _mm_loadu_pd(weights + i);
+                const __m128d is_shorter = _mm_cmplt_pd(candidate_weights, current_weights);
+                if (_mm_movemask_pd(is_shorter) == 0) {
+                    continue;
+                }
+                _mm_storeu_pd(weights + i, _mm_blendv_pd(current_weights, candidate_weights, is_shorter));
+                const __m128i edge_mask = _mm_shuffle_epi32(_mm_castpd_si128(is_shorter), _MM_SHUFFLE(2, 0, 2, 0));
+                __m128i* prev = reinterpret_cast<__m128i*>(prev_edges + i);
+                const __m128i through_prev = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(through_prev_edges + i));
+                _mm_storel_epi64(prev, _mm_blendv_epi8(_mm_loadl_epi64(prev), through_prev, edge_mask));
+            }
+            RelaxRowScalar(weights + i, prev_edges + i, through_weights + i, through_prev_edges + i,
+                weight_from, count - i);
+        }
+
+        __attribute__((target("sse4.1")))
+        void RelaxRowSse41(float* weights, uint32_t* prev_edges, const float* through_weights,
+            const uint32_t* through_prev_edges, float weight_from, size_t count) {
+            const __m128 from = _mm_set1_ps(weight_from);
+            size_t i = 0;
+            for (; i + 4 <= count; i += 4) {
+                const __m128 candidate_weights = _mm_add_ps(from, _mm_loadu_ps(through_weights + i));
+                const __m128 current_weights = _mm_loadu_ps(weights + i);
+                const __m128 is_shorter = _mm_cmplt_ps(candidate_weights, current_weights);
+                if (_mm_movemask_ps(is_shorter) == 0) {
+                    continue;
+                }
+                _mm_storeu_ps(weights + i, _mm_blendv_ps(current_weights, candidate_weights, is_shorter));
+                __m128i* prev = reinterpret_cast<__m128i*>(prev_edges + i);
+                const __m128i through_prev = _mm_loadu_si128(reinterpret_cast<const __m128i*>(through_prev_edges + i));
+                _mm_storeu_si128(prev, _mm_blendv_epi8(_mm_loadu_si128(prev), through_prev,
+                    _mm_castps_si128(is_shorter)));
+            }
+            RelaxRowScalar(weights + i, prev_edges + i, through_weights + i, through_prev_edges + i,
+                weight_from, count - i);
+        }
+
+        __attribute__((target("sse4.1")))
+        void RelaxRowSse41(uint32_t* weights, uint32_t* prev_edges, const uint32_t* through_weights,
+            const uint32_t* through_prev_edges, uint32_t weight_from, size_t count) {
+            const __m128i from = _mm_set1_epi32(static_cast<int>(weight_from));
+            size_t i = 0;
+            for (; i + 4 <= count; i += 4) {
+                const __m128i sum = _mm_add_epi32(from,
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(through_weights + i)));
+                const __m128i is_not_overflow = _mm_cmpeq_epi32(_mm_max_epu32(sum, from), sum);
+                const __m128i candidate_weights = _mm_or_si128(sum, _mm_xor_si128(is_not_overflow, _mm_set1_epi32(-1)));
+                __m128i* current = reinterpret_cast<__m128i*>(weights + i);
+                const __m128i current_weights = _mm_loadu_si128(current);
+                const __m128i is_shorter = _mm_andnot_si128(_mm_cmpeq_epi32(candidate_weights, current_weights),
+                    _mm_cmpeq_epi32(_mm_min_epu32(candidate_weights, current_weights), candidate_weights));
+                if (_mm_testz_si128(is_shorter, is_shorter)) {
+                    continue;
+                }
+                _mm_storeu_si128(current, _mm_blendv_epi8(current_weights, candidate_weights, is_shorter));
+                __m128i* prev = reinterpret_cast<__m128i*>(prev_edges + i);
+                const __m128i through_prev = _mm_loadu_si128(reinterpret_cast<const __m128i*>(through_prev_edges + i));
+                _mm_storeu_si128(prev, _mm_blendv_epi8(_mm_loadu_si128(prev), through_prev, is_shorter));
+            }
+            RelaxRowScalar(weights + i, prev_edges + i, through_weights + i, through_prev_edges + i,
+                weight_from, count - i);
+        }
+
+#endif
+
+        Kernel SelectKernel() {
+#ifdef TCAT_MIN_PLUS_X86
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2")) {
+                return Kernel::AVX2;
+            }
+            if (__builtin_cpu_supports("sse4.1")) {
+                return Kernel::SSE41;
+            }
+#endif
+            return Kernel::SCALAR;
+        }
+
+        Kernel GetKernel() {
+            static const Kernel kernel = SelectKernel();
+            return kernel;
+        }
+
+        template <typename Weight>
+        RelaxRowFunction<Weight> SelectRelaxRow() {
+#ifdef TCAT_MIN_PLUS_X86
+            switch (GetKernel()) {
+            case Kernel::AVX2:
+                return static_cast<RelaxRowFunction<Weight>>(&RelaxRowAvx2);
+            case Kernel::SSE41:
+                return static_cast<RelaxRowFunction<Weight>>(&RelaxRowSse41);
+            default:
+                break;
+            }
+#endif
+            return static_cast<RelaxRowFunction<Weight>>(&RelaxRowScalar);
+        }
+
+    } // namespace
+
+    void RelaxRowScalar(uint32_t* weights, uint32_t* prev_edges, const uint32_t* through_weights,
+        const uint32_t* through_prev_edges, uint32_t weight_from, size_t count) {
+        constexpr uint64_t MAX_WEIGHT = std::numeric_limits<uint32_t>::max();
+        for (size_t i = 0; i < count; ++i) {
+            const uint64_t sum = static_cast<uint64_t>(weight_from) + through_weights[i];
+            const uint32_t candidate_weight = static_cast<uint32_t>(sum < MAX_WEIGHT ? sum : MAX_WEIGHT);
+            if (candidate_weight < weights[i]) {
+                weights[i] = candidate_weight;
+                prev_edges[i] = through_prev_edges[i];
+            }
+        }
+    }
+
+    void RelaxRowMinPlus(double* weights, uint32_t* prev_edges, const double* through_weights,
+        const uint32_t* through_prev_edges, double weight_from, size_t count) {
+        static const RelaxRowFunction<double> relax_row = SelectRelaxRow<double>();
+        relax_row(weights, prev_edges, through_weights, through_prev_edges, weight_from, count);
+    }
+
+    void RelaxRowMinPlus(float* weights, uint32_t* prev_edges, const float* through_weights,
+        const uint32_t* through_prev_edges, float weight_from, size_t count) {
+        static const RelaxRowFunction<float> relax_row = SelectRelaxRow<float>();
+        relax_row(weights, prev_edges, through_weights, through_prev_edges, weight_from, count);
+    }
+
+    void RelaxRowMinPlus(uint32_t* weights, uint32_t* prev_edges, const uint32_t* through_weights,
+        const uint32_t* through_prev_edges, uint32_t weight_from, size_t count) {
+        static const RelaxRowFunction<uint32_t> relax_row = SelectRelaxRow<uint32_t>();
+        relax_row(weights, prev_edges, through_weights, through_prev_edges, weight_from, count);
+    }
+
+    const char* GetMinPlusKernelName() {
+        switch (GetKernel()) {
+        case Kernel::AVX2:
+            return "avx2";
+        case Kernel::SSE41:
+            return "sse4.1";
+        default:
+            return "scalar";
+        }
+    }
+
+} // namespace graph
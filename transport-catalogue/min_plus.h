@@ -0,0 +1,57 @@
+#pragma once
+
+#include "fixed_weight.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace graph {
+
+    // Релаксация строки таблицы маршрутов через промежуточную вершину (min-plus): для каждого i,
+    // если weight_from + through_weights[i] < weights[i], вес заменяется суммой, а последнее ребро -
+    // through_prev_edges[i]. Для double, float и uint32 реализация выбирается при первом вызове
+    // по возможностям процессора: AVX2, SSE4.1 или скалярная
+    void RelaxRowMinPlus(double* weights, uint32_t* prev_edges, const double* through_weights,
+        const uint32_t* through_prev_edges, double weight_from, size_t count);
+    void RelaxRowMinPlus(float* weights, uint32_t* prev_edges, const float* through_weights,
+        const uint32_t* through_prev_edges, float weight_from, size_t count);
+    // Веса фиксированной точки в целом виде: сумма с насыщением до максимума (бесконечности)
+    void RelaxRowMinPlus(uint32_t* weights, uint32_t* prev_edges, const uint32_t* through_weights,
+        const uint32_t* through_prev_edges, uint32_t weight_from, size_t count);
+
+    template <uint32_t Scale>
+    void RelaxRowMinPlus(FixedWeight<Scale>* weights, uint32_t* prev_edges, const FixedWeight<Scale>* through_weights,
+        const uint32_t* through_prev_edges, FixedWeight<Scale> weight_from, size_t count) {
+        static_assert(sizeof(FixedWeight<Scale>) == sizeof(uint32_t));
+        RelaxRowMinPlus(reinterpret_cast<uint32_t*>(weights), prev_edges,
+            reinterpret_cast<const uint32_t*>(through_weights), through_prev_edges, weight_from.GetRaw(), count);
+    }
+
+    // Скалярная реализация: ячейка записывается только при улучшении, как и в векторных блоках, -
+    // без улучшений строка (и страница таблицы) остается нетронутой. Ею же обрабатываются хвосты
+    // строк векторных реализаций и остальные типы весов
+    template <typename Weight>
+    void RelaxRowScalar(Weight* weights, uint32_t* prev_edges, const Weight* through_weights,
+        const uint32_t* through_prev_edges, Weight weight_from, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            const Weight candidate_weight = weight_from + through_weights[i];
+            if (candidate_weight < weights[i]) {
+                weights[i] = candidate_weight;
+                prev_edges[i] = through_prev_edges[i];
+            }
+        }
+    }
+    // Для весов фиксированной точки - сумма с насыщением
+    void RelaxRowScalar(uint32_t* weights, uint32_t* prev_edges, const uint32_t* through_weights,
+        const uint32_t* through_prev_edges, uint32_t weight_from, size_t count);
+
+    template <typename Weight>
+    void RelaxRowMinPlus(Weight* weights, uint32_t* prev_edges, const Weight* through_weights,
+        const uint32_t* through_prev_edges, Weight weight_from, size_t count) {
+        RelaxRowScalar(weights, prev_edges, through_weights, through_prev_edges, weight_from, count);
+    }
+
+    // Имя выбранной реализации ("avx2", "sse4.1" или "scalar")
+    const char* GetMinPlusKernelName();
+
+} // namespace graph
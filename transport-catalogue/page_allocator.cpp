@@ -0,0 +1,124 @@
+#include "page_allocator.h"
+
+#include <cstdint>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+using namespace std;
+
+namespace storage {
+
+    namespace {
+
+        // Размер большой страницы x86-64 и ARM64 с 4K-страницами. Блоки меньше него выделяются как обычно
+        constexpr size_t HUGE_PAGE_SIZE = size_t{ 2 } << 20;
+
+        size_t RoundUp(size_t size, size_t alignment) {
+            return (size + alignment - 1) / alignment * alignment;
+        }
+
+        bool IsMapped(size_t size, PageMode mode) {
+            return mode != PageMode::DEFAULT && size >= HUGE_PAGE_SIZE;
+        }
+
+    } // namespace
+
+#ifdef _WIN32
+
+    namespace {
+
+        // Большие страницы Windows требуют права SeLockMemoryPrivilege, без него - обычные страницы.
+        // Прозрачных больших страниц в Windows нет
+        void* MapPages(size_t size, PageMode mode) {
+            if (mode == PageMode::EXPLICIT_HUGE) {
+                if (const size_t large_page_size = GetLargePageMinimum()) {
+                    void* data = VirtualAlloc(nullptr, RoundUp(size, large_page_size),
+                        MEM_COMMIT | MEM_RESERVE | MEM_LARGE_PAGES, PAGE_READWRITE);
+                    if (data) {
+                        return data;
+                    }
+                }
+            }
+            return VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+        }
+
+        void UnmapPages(void* data, size_t) noexcept {
+            VirtualFree(data, 0, MEM_RELEASE);
+        }
+
+    } // namespace
+
+#else
+
+    namespace {
+
+        void* MapPages(size_t size, PageMode mode) {
+            size = RoundUp(size, HUGE_PAGE_SIZE);
+#ifdef MAP_HUGETLB
+            if (mode == PageMode::EXPLICIT_HUGE) {
+                void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+                if (data != MAP_FAILED) {
+                    return data;
+                }
+            }
+#endif
+            // Ядро отдает большими страницами только выровненные по ним участки: отображение с запасом
+            // в одну большую страницу, лишнее в начале и в конце возвращается
+            void* data = mmap(nullptr, size + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (data == MAP_FAILED) {
+                return nullptr;
+            }
+            const uintptr_t begin = reinterpret_cast<uintptr_t>(data);
+            const uintptr_t aligned_begin = RoundUp(begin, HUGE_PAGE_SIZE);
+            if (aligned_begin != begin) {
+                munmap(data, aligned_begin - begin);
+            }
+            if (const size_t tail = begin + HUGE_PAGE_SIZE - aligned_begin) {
+                munmap(reinterpret_cast<void*>(aligned_begin + size), tail);
+            }
+            data = reinterpret_cast<void*>(aligned_begin);
+#ifdef MADV_HUGEPAGE
+            // Отказ (ядро без прозрачных больших страниц) не ошибка - остаются обычные страницы
+            madvise(data, size, MADV_HUGEPAGE);
+#endif
+            return data;
+        }
+
+        void UnmapPages(void* data, size_t size) noexcept {
+            munmap(data, RoundUp(size, HUGE_PAGE_SIZE));
+        }
+
+    } // namespace
+
+#endif
+
+    void* AllocatePages(size_t size, PageMode mode) {
+        if (!IsMapped(size, mode)) {
+            return ::operator new(size);
+        }
+        void* data = MapPages(size, mode);
+        if (!data) {
+            throw bad_alloc();
+        }
+        return data;
+    }
+
+    void FreePages(void* data, size_t size, PageMode mode) noexcept {
+        if (!data) {
+            return;
+        }
+        if (!IsMapped(size, mode)) {
+            ::operator delete(data);
+            return;
+        }
+        UnmapPages(data, size);
+    }
+
+} // namespace storage
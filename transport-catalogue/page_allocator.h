@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+namespace storage {
+
+    // Страницы памяти больших буферов: обычные (DEFAULT), прозрачные большие страницы ядра
+    // (TRANSPARENT_HUGE, madvise) или заранее выделенные большие страницы (EXPLICIT_HUGE, MAP_HUGETLB).
+    // Если больших страниц нет, память выделяется обычными страницами
+    enum class PageMode {
+        DEFAULT,
+        TRANSPARENT_HUGE,
+        EXPLICIT_HUGE
+    };
+
+    // Блок size байт. Блоки меньше большой страницы и блоки в режиме DEFAULT выделяются через
+    // operator new, остальные - отдельным отображением памяти. Освобождать с теми же size и mode
+    void* AllocatePages(size_t size, PageMode mode);
+    void FreePages(void* data, size_t size, PageMode mode) noexcept;
+
+    // Аллокатор для std::vector с режимом страниц. Режим передается вместе с контейнером
+    // при копировании, перемещении и обмене
+    template <typename T>
+    class PageAllocator {
+
+    public:
+
+        using value_type = T;
+        using propagate_on_container_copy_assignment = std::true_type;
+        using propagate_on_container_move_assignment = std::true_type;
+        using propagate_on_container_swap = std::true_type;
+
+        PageAllocator() = default;
+        explicit PageAllocator(PageMode mode)
+            : mode_(mode) {}
+        template <typename U>
+        PageAllocator(const PageAllocator<U>& other)
+            : mode_(other.GetMode()) {}
+
+        T* allocate(size_t count) {
+            if (count > static_cast<size_t>(-1) / sizeof(T)) {
+                throw std::bad_array_new_length();
+            }
+            return static_cast<T*>(AllocatePages(count * sizeof(T), mode_));
+        }
+
+        void deallocate(T* data, size_t count) noexcept {
+            FreePages(data, count * sizeof(T), mode_);
+        }
+
+        PageMode GetMode() const {
+            return mode_;
+        }
+
+        template <typename U>
+        friend bool operator==(const PageAllocator& lhs, const PageAllocator<U>& rhs) {
+            return lhs.GetMode() == rhs.GetMode();
+        }
+        template <typename U>
+        friend bool operator!=(const PageAllocator& lhs, const PageAllocator<U>& rhs) {
+            return lhs.GetMode() != rhs.GetMode();
+        }
+
+    private:
+
+        PageMode mode_ = PageMode::DEFAULT;
+    };
+
+} // namespace storage
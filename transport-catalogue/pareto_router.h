@@ -0,0 +1,229 @@
+#pragma once
+
+#include "dijkstra_router.h"
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+    // Маршрут с весом и числом отмеченных ребер на нем (например, посадок)
+    template <typename Weight>
+    struct ParetoRoute {
+        uint32_t count;
+        RouteInfo<Weight> route_info;
+    };
+
+    // Поиск по двум критериям: вес маршрута и число отмеченных ребер. Метки (вес, число) извлекаются
+    // из очереди в порядке возрастания веса, поэтому метка вершины доминируется, если в вершине
+    // уже раскрыта метка с не большим числом, - достаточно хранить минимальное раскрытое число на вершину.
+    // Метки, доминируемые уже найденными маршрутами до цели, отсекаются так же, причем из вершины,
+    // все исходящие ребра которой отмечены, до цели не дойти без еще одного отмеченного ребра.
+    // Метки в очереди тоже доминируют: для малых чисел хранится минимальный вес меток вершины
+    // с числом не больше данного, и новая метка не тяжелее и не хуже по числу в очередь не попадает
+    template <typename Weight>
+    class ParetoRouter {
+
+    private:
+
+        using Graph = DirectedWeightedGraph<Weight>;
+
+    public:
+
+        using RouteInfo = graph::RouteInfo<Weight>;
+
+        // is_counted(edge) - учитывается ли ребро во втором критерии
+        template <typename IsCounted>
+        ParetoRouter(const Graph& graph, IsCounted is_counted);
+
+        // Парето-оптимальные маршруты из from в to с числом отмеченных ребер не больше max_count:
+        // по возрастанию числа, каждый следующий строго быстрее предыдущего
+        std::vector<ParetoRoute<Weight>> BuildRoutes(VertexId from, VertexId to,
+            uint32_t max_count = std::numeric_limits<uint32_t>::max()) const;
+        SearchStats GetSearchStats() const;
+
+    private:
+
+        static constexpr uint32_t NO_COUNT = std::numeric_limits<uint32_t>::max();
+        static constexpr uint32_t NO_LABEL = std::numeric_limits<uint32_t>::max();
+        // Для скольких младших чисел проверяется доминирование метками в очереди
+        static constexpr uint32_t QUEUED_COUNT_LAYERS = 8;
+
+        struct Label {
+            Weight weight;
+            uint32_t count;
+            VertexId vertex;
+            uint32_t prev_label;
+            EdgeId edge;
+        };
+
+        // Буферы на поток, как в DijkstraRouter: min_counts и queued_weights действительны
+        // только с текущим epoch. queued_weights[count * vertex_count + vertex] - минимальный вес
+        // меток вершины в очереди с числом не больше count
+        struct SearchData {
+            std::vector<Label> labels;
+            std::vector<uint32_t> min_counts;
+            std::vector<uint32_t> reached;
+            std::vector<Weight> queued_weights;
+            std::vector<uint32_t> queued;
+            std::vector<std::tuple<Weight, uint32_t, uint32_t>> queue;
+            uint32_t epoch = 0;
+
+            void Reset(size_t vertex_count) {
+                if (reached.size() != vertex_count) {
+                    min_counts.assign(vertex_count, NO_COUNT);
+                    reached.assign(vertex_count, 0);
+                    queued_weights.assign(vertex_count * QUEUED_COUNT_LAYERS, ZERO_WEIGHT);
+                    queued.assign(vertex_count * QUEUED_COUNT_LAYERS, 0);
+                    epoch = 0;
+                }
+                if (++epoch == 0) {
+                    std::fill(reached.begin(), reached.end(), 0);
+                    std::fill(queued.begin(), queued.end(), 0);
+                    epoch = 1;
+                }
+                labels.clear();
+                queue.clear();
+            }
+
+            uint32_t GetMinCount(VertexId vertex) const {
+                return reached[vertex] == epoch ? min_counts[vertex] : NO_COUNT;
+            }
+
+            // Доминируется ли метка (weight, count) вершины меткой в очереди; если нет, она учитывается
+            bool IsQueuedDominated(VertexId vertex, Weight weight, uint32_t count) {
+                if (count >= QUEUED_COUNT_LAYERS) {
+                    return false;
+                }
+                const size_t vertex_count = reached.size();
+                size_t index = count * vertex_count + vertex;
+                if (queued[index] == epoch && !(weight < queued_weights[index])) {
+                    return true;
+                }
+                for (; index < queued.size(); index += vertex_count) {
+                    if (queued[index] != epoch || weight < queued_weights[index]) {
+                        queued[index] = epoch;
+                        queued_weights[index] = weight;
+                    }
+                }
+                return false;
+            }
+        };
+
+        static SearchData& GetSearchData() {
+            static thread_local SearchData search_data;
+            return search_data;
+        }
+
+        static constexpr Weight ZERO_WEIGHT{};
+        const Graph& graph_;
+        std::vector<uint8_t> edge_counts_;
+        // Нижняя оценка числа отмеченных ребер от вершины до любой другой вершины (0 или 1)
+        std::vector<uint8_t> min_leave_counts_;
+        mutable std::atomic<size_t> searches_ = 0;
+        mutable std::atomic<size_t> settled_vertices_ = 0;
+    };
+
+    template <typename Weight>
+    template <typename IsCounted>
+    ParetoRouter<Weight>::ParetoRouter(const Graph& graph, IsCounted is_counted)
+        : graph_(graph)
+        , edge_counts_(graph.GetEdgeCount())
+        , min_leave_counts_(graph.GetVertexCount(), 1) {
+        const size_t edge_count = graph.GetEdgeCount();
+        for (EdgeId edge_id = 0; edge_id < edge_count; ++edge_id) {
+            const Edge<Weight>& edge = graph.GetEdge(edge_id);
+            if (edge.weight < ZERO_WEIGHT) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+            edge_counts_[edge_id] = is_counted(edge) ? 1 : 0;
+            if (!edge_counts_[edge_id]) {
+                min_leave_counts_[edge.from] = 0;
+            }
+        }
+    }
+
+    template <typename Weight>
+    std::vector<ParetoRoute<Weight>> ParetoRouter<Weight>::BuildRoutes(VertexId from, VertexId to,
+        uint32_t max_count) const {
+        const size_t vertex_count = graph_.GetVertexCount();
+        if (from >= vertex_count || to >= vertex_count) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+
+        SearchData& data = GetSearchData();
+        data.Reset(vertex_count);
+        const uint32_t epoch = data.epoch;
+        const auto queue_order = std::greater<std::tuple<Weight, uint32_t, uint32_t>>{};
+        std::vector<uint32_t> target_labels;
+        size_t settled_count = 0;
+
+        data.labels.push_back({ ZERO_WEIGHT, 0, from, NO_LABEL, 0 });
+        data.queue.push_back({ ZERO_WEIGHT, 0, 0 });
+
+        while (!data.queue.empty()) {
+            std::pop_heap(data.queue.begin(), data.queue.end(), queue_order);
+            const auto [weight, count, label_id] = data.queue.back();
+            data.queue.pop_back();
+            const VertexId vertex = data.labels[label_id].vertex;
+            // Метки извлекаются по возрастанию веса: раскрытые раньше не тяжелее этой
+            if (data.GetMinCount(vertex) <= count
+                || (vertex != to && data.GetMinCount(to) <= count + min_leave_counts_[vertex])) {
+                continue;
+            }
+            data.reached[vertex] = epoch;
+            data.min_counts[vertex] = count;
+            ++settled_count;
+            if (vertex == to) {
+                target_labels.push_back(label_id);
+                continue;
+            }
+
+            for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+                const auto& edge = graph_.GetEdge(edge_id);
+                const uint32_t next_count = count + edge_counts_[edge_id];
+                if (next_count > max_count || data.GetMinCount(edge.to) <= next_count
+                    || data.GetMinCount(to) <= next_count + (edge.to == to ? 0 : min_leave_counts_[edge.to])
+                    || data.IsQueuedDominated(edge.to, weight + edge.weight, next_count)) {
+                    continue;
+                }
+                const uint32_t next_label = static_cast<uint32_t>(data.labels.size());
+                data.labels.push_back({ weight + edge.weight, next_count, edge.to, label_id, edge_id });
+                data.queue.push_back({ weight + edge.weight, next_count, next_label });
+                std::push_heap(data.queue.begin(), data.queue.end(), queue_order);
+            }
+        }
+        searches_.fetch_add(1, std::memory_order_relaxed);
+        settled_vertices_.fetch_add(settled_count, std::memory_order_relaxed);
+
+        // Маршруты до цели найдены по возрастанию веса, то есть по убыванию числа
+        std::vector<ParetoRoute<Weight>> result;
+        result.reserve(target_labels.size());
+        for (auto it = target_labels.rbegin(); it != target_labels.rend(); ++it) {
+            const Label& target_label = data.labels[*it];
+            std::vector<EdgeId> edges;
+            for (uint32_t label_id = *it; data.labels[label_id].prev_label != NO_LABEL;
+                label_id = data.labels[label_id].prev_label) {
+                edges.push_back(data.labels[label_id].edge);
+            }
+            std::reverse(edges.begin(), edges.end());
+            result.push_back({ target_label.count, RouteInfo{ target_label.weight, std::move(edges) } });
+        }
+        return result;
+    }
+
+    template <typename Weight>
+    SearchStats ParetoRouter<Weight>::GetSearchStats() const {
+        return { searches_.load(std::memory_order_relaxed), settled_vertices_.load(std::memory_order_relaxed) };
+    }
+
+}  // namespace graph
@@ -0,0 +1,270 @@
+#include "raptor_router.h"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+using namespace std;
+
+namespace transport {
+
+    namespace {
+
+        constexpr double NO_ARRIVAL = numeric_limits<double>::infinity();
+        constexpr uint32_t NO_TRIP_START = numeric_limits<uint32_t>::max();
+        constexpr uint32_t NO_STOP = numeric_limits<uint32_t>::max();
+
+    } // namespace
+
+    RaptorRouter::RaptorRouter(const Catalogue& tcat, int bus_wait_time, double bus_velocity)
+        : bus_wait_time_(bus_wait_time)
+        , bus_speed_(bus_velocity * (100.0 / 6.0)) {
+        for (const auto& [stop_name, stop_ptr] : tcat.GetSortedAllStops()) {
+            stop_indices_[stop_ptr] = static_cast<uint32_t>(stops_.size());
+            stops_.push_back(stop_ptr);
+        }
+
+        for (const auto& [bus_name, bus_ptr] : tcat.GetSortedAllBuses()) {
+            const size_t stops_count = bus_ptr->stops.size();
+            if (stops_count < 2) {
+                continue;
+            }
+            if (bus_ptr->is_circle) {
+                AddTrip(bus_ptr, 0, stops_count - 1);
+            }
+            else {
+                AddTrip(bus_ptr, 0, stops_count / 2);
+                AddTrip(bus_ptr, stops_count / 2, stops_count - 1);
+            }
+        }
+
+        // Рейсы через каждую остановку в плоском виде
+        stop_trip_offsets_.assign(stops_.size() + 1, 0);
+        for (const uint32_t stop : trip_stops_) {
+            ++stop_trip_offsets_[stop + 1];
+        }
+        for (size_t stop = 0; stop < stops_.size(); ++stop) {
+            stop_trip_offsets_[stop + 1] += stop_trip_offsets_[stop];
+        }
+        stop_trips_.resize(trip_stops_.size());
+        vector<size_t> positions(stop_trip_offsets_.begin(), stop_trip_offsets_.end() - 1);
+        for (uint32_t trip = 0; trip < trips_.size(); ++trip) {
+            for (size_t i = trips_[trip].begin; i < trips_[trip].end; ++i) {
+                stop_trips_[positions[trip_stops_[i]]++] = { trip, static_cast<uint32_t>(i - trips_[trip].begin) };
+            }
+        }
+    }
+
+    void RaptorRouter::AddTrip(const Bus* bus, size_t first, size_t last) {
+        if (first >= last) {
+            return;
+        }
+        const size_t begin = trip_stops_.size();
+        int distance = 0;
+        for (size_t i = first; i <= last; ++i) {
+            if (i > first) {
+                distance += bus->stops[i - 1]->GetDistance(bus->stops[i]);
+            }
+            trip_stops_.push_back(stop_indices_.at(bus->stops[i]));
+            trip_distances_.push_back(distance);
+        }
+        trips_.push_back({ bus, begin, trip_stops_.size(), bus_speed_ });
+    }
+
+    void RaptorRouter::SetBusWaitTime(int bus_wait_time) {
+        bus_wait_time_ = bus_wait_time;
+    }
+
+    void RaptorRouter::SetBusVelocity(const Bus* bus, double bus_velocity) {
+        for (Trip& trip : trips_) {
+            if (trip.bus == bus) {
+                trip.speed = bus_velocity * (100.0 / 6.0);
+            }
+        }
+    }
+
+    std::optional<RaptorRouter::Route> RaptorRouter::BuildRoute(const Stop* from, const Stop* to) const {
+        const uint32_t source = stop_indices_.at(from);
+        const uint32_t target = stop_indices_.at(to);
+        if (source == target) {
+            return Route{ 0.0, {} };
+        }
+
+        SearchData& data = GetSearchData();
+        size_t round = RunRounds(data, source, target, NO_ARRIVAL);
+
+        if (data.arrivals[round][target] == NO_ARRIVAL) {
+            return nullopt;
+        }
+        return ExtractRoute(data, source, target, round);
+    }
+
+    std::vector<RaptorRouter::Route> RaptorRouter::BuildParetoRoutes(const Stop* from, const Stop* to) const {
+        const uint32_t source = stop_indices_.at(from);
+        const uint32_t target = stop_indices_.at(to);
+        if (source == target) {
+            return { Route{ 0.0, {} } };
+        }
+
+        SearchData& data = GetSearchData();
+        const size_t last_round = RunRounds(data, source, target, NO_ARRIVAL);
+        // Прибытие в цель улучшается в раунде k - это самый быстрый маршрут не более чем с k посадками
+        std::vector<Route> result;
+        for (size_t round = 1; round <= last_round; ++round) {
+            if (data.improved[round][target]) {
+                result.push_back(ExtractRoute(data, source, target, round));
+            }
+        }
+        return result;
+    }
+
+    RaptorRouter::Route RaptorRouter::ExtractRoute(const SearchData& data, uint32_t source, uint32_t target,
+        size_t round) const {
+        // Восстановление поездок с конца: в каждом раунде ищем, где остановка получила свою метку
+        Route result{ data.arrivals[round][target], {} };
+        uint32_t stop = target;
+        while (stop != source || round > 0) {
+            while (!data.improved[round][stop]) {
+                --round;
+            }
+            if (round == 0) {
+                break;
+            }
+            const Label& label = data.labels[round][stop];
+            const Trip& trip = trips_[label.trip];
+            const uint32_t board_stop = trip_stops_[trip.begin + label.board_position];
+            result.legs.push_back({
+                trip.bus,
+                stops_[board_stop],
+                label.alight_position - label.board_position,
+                static_cast<double>(trip_distances_[trip.begin + label.alight_position]
+                    - trip_distances_[trip.begin + label.board_position]) / trip.speed
+                });
+            stop = board_stop;
+            --round;
+        }
+        reverse(result.legs.begin(), result.legs.end());
+
+        return result;
+    }
+
+    std::vector<std::optional<double>> RaptorRouter::GetTravelTimes(const Stop* from,
+        const std::vector<const Stop*>& to) const {
+        SearchData& data = GetSearchData();
+        const size_t round = RunRounds(data, stop_indices_.at(from), NO_STOP, NO_ARRIVAL);
+        std::vector<std::optional<double>> result(to.size());
+        for (size_t i = 0; i < to.size(); ++i) {
+            const double arrival = data.arrivals[round][stop_indices_.at(to[i])];
+            if (arrival != NO_ARRIVAL) {
+                result[i] = arrival;
+            }
+        }
+        return result;
+    }
+
+    std::vector<std::pair<const Stop*, double>> RaptorRouter::GetReachableStops(const Stop* from,
+        double max_time) const {
+        SearchData& data = GetSearchData();
+        const size_t round = RunRounds(data, stop_indices_.at(from), NO_STOP, max_time);
+        std::vector<std::pair<const Stop*, double>> result;
+        for (size_t stop = 0; stop < stops_.size(); ++stop) {
+            if (data.arrivals[round][stop] <= max_time) {
+                result.push_back({ stops_[stop], data.arrivals[round][stop] });
+            }
+        }
+        return result;
+    }
+
+    size_t RaptorRouter::RunRounds(SearchData& data, uint32_t source, uint32_t target, double max_arrival) const {
+        const size_t stops_count = stops_.size();
+        data.trip_starts.assign(trips_.size(), NO_TRIP_START);
+        data.queued_trips.clear();
+        data.marked_stops.assign(1, source);
+
+        auto prepare_round = [&data, stops_count](size_t round) {
+            if (data.arrivals.size() <= round) {
+                data.arrivals.resize(round + 1);
+                data.labels.resize(round + 1);
+                data.improved.resize(round + 1);
+            }
+            if (round == 0) {
+                data.arrivals[0].assign(stops_count, NO_ARRIVAL);
+            }
+            else {
+                data.arrivals[round] = data.arrivals[round - 1];
+            }
+            data.labels[round].resize(stops_count);
+            data.improved[round].assign(stops_count, false);
+        };
+
+        prepare_round(0);
+        data.arrivals[0][source] = 0.0;
+        data.improved[0][source] = true;
+
+        size_t round = 0;
+        while (!data.marked_stops.empty()) {
+            ++round;
+            prepare_round(round);
+            const vector<double>& prev_arrivals = data.arrivals[round - 1];
+            vector<double>& arrivals = data.arrivals[round];
+            // Без целевой остановки отсечения по времени прибытия в нее нет
+            const double& target_arrival = target == NO_STOP ? NO_ARRIVAL : arrivals[target];
+            // Рейсы через отмеченные остановки, для каждого - самая ранняя отмеченная позиция
+            for (const uint32_t stop : data.marked_stops) {
+                for (size_t i = stop_trip_offsets_[stop]; i < stop_trip_offsets_[stop + 1]; ++i) {
+                    const auto [trip, position] = stop_trips_[i];
+                    if (data.trip_starts[trip] == NO_TRIP_START) {
+                        data.queued_trips.push_back(trip);
+                        data.trip_starts[trip] = position;
+                    }
+                    else {
+                        data.trip_starts[trip] = min(data.trip_starts[trip], position);
+                    }
+                }
+            }
+            data.marked_stops.clear();
+
+            for (const uint32_t trip_id : data.queued_trips) {
+                const Trip& trip = trips_[trip_id];
+                const uint32_t* trip_stops = &trip_stops_[trip.begin];
+                const int* trip_distances = &trip_distances_[trip.begin];
+                const uint32_t trip_size = static_cast<uint32_t>(trip.end - trip.begin);
+                bool is_boarded = false;
+                uint32_t board_position = 0;
+
+                for (uint32_t position = data.trip_starts[trip_id]; position < trip_size; ++position) {
+                    const uint32_t stop = trip_stops[position];
+                    if (is_boarded) {
+                        const double ride_time = static_cast<double>(trip_distances[position]
+                            - trip_distances[board_position]) / trip.speed;
+                        const double arrival = prev_arrivals[trip_stops[board_position]] + bus_wait_time_ + ride_time;
+                        if (arrival < arrivals[stop] && arrival < target_arrival && arrival <= max_arrival) {
+                            arrivals[stop] = arrival;
+                            data.labels[round][stop] = { trip_id, board_position, position };
+                            if (!data.improved[round][stop]) {
+                                data.improved[round][stop] = true;
+                                data.marked_stops.push_back(stop);
+                            }
+                        }
+                    }
+                    // Пересесть на этот рейс здесь выгоднее, если сюда можно добраться раньше,
+                    // чем текущий рейс сюда доедет
+                    if (prev_arrivals[stop] != NO_ARRIVAL) {
+                        const bool is_better_board = !is_boarded
+                            || prev_arrivals[stop] < prev_arrivals[trip_stops[board_position]]
+                            + static_cast<double>(trip_distances[position] - trip_distances[board_position]) / trip.speed;
+                        if (is_better_board) {
+                            is_boarded = true;
+                            board_position = position;
+                        }
+                    }
+                }
+                data.trip_starts[trip_id] = NO_TRIP_START;
+            }
+            data.queued_trips.clear();
+        }
+
+        return round;
+    }
+
+} // namespace transport
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "domain.h"
+#include "transport_catalogue.h"
+
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace transport {
+
+    // Поиск маршрута по раундам (RAPTOR) прямо по спискам остановок автобусов, без графа всех пар
+    // остановок маршрута. Раунд k - маршруты ровно с k посадками, каждая посадка стоит bus_wait_time.
+    // Некольцевой автобус разбит на два рейса (туда и обратно), проехать через конечную без новой
+    // посадки нельзя - так же, как в графе transport::Router
+    class RaptorRouter {
+
+    public:
+
+        // Одна поездка: посадка на автобус bus на остановке board_stop и проезд span_count перегонов
+        struct Leg {
+            const Bus* bus;
+            const Stop* board_stop;
+            size_t span_count;
+            double ride_time;
+        };
+
+        struct Route {
+            double total_time;
+            std::vector<Leg> legs;
+        };
+
+        RaptorRouter(const Catalogue& tcat, int bus_wait_time, double bus_velocity);
+
+        // Изменение времени ожидания и скорости одного автобуса без перестроения рейсов
+        void SetBusWaitTime(int bus_wait_time);
+        void SetBusVelocity(const Bus* bus, double bus_velocity);
+
+        std::optional<Route> BuildRoute(const Stop* from, const Stop* to) const;
+        // Самые быстрые маршруты с каждым числом посадок, при котором маршрут быстрее, чем с меньшим
+        // числом, - по возрастанию числа посадок. Раунды RAPTOR дают их за один поиск
+        std::vector<Route> BuildParetoRoutes(const Stop* from, const Stop* to) const;
+        // Время в пути из from до каждой остановки to одним поиском без отсечения по цели
+        std::vector<std::optional<double>> GetTravelTimes(const Stop* from, const std::vector<const Stop*>& to) const;
+        // Остановки, до которых можно доехать из from не дольше max_time, и время до них.
+        // Прибытия позже max_time отсекаются в каждом раунде
+        std::vector<std::pair<const Stop*, double>> GetReachableStops(const Stop* from, double max_time) const;
+
+    private:
+
+        // Рейс: подряд идущие остановки автобуса, [begin, end) в trip_stops_
+        struct Trip {
+            const Bus* bus;
+            size_t begin;
+            size_t end;
+            // Скорость автобуса, метры в минуту
+            double speed;
+        };
+
+        struct StopTrip {
+            uint32_t trip;
+            uint32_t position;
+        };
+
+        struct Label {
+            uint32_t trip;
+            uint32_t board_position;
+            uint32_t alight_position;
+        };
+
+        struct SearchData {
+            std::vector<std::vector<double>> arrivals;
+            std::vector<std::vector<Label>> labels;
+            std::vector<std::vector<char>> improved;
+            std::vector<uint32_t> marked_stops;
+            std::vector<uint32_t> trip_starts;
+            std::vector<uint32_t> queued_trips;
+        };
+
+        static SearchData& GetSearchData() {
+            static thread_local SearchData search_data;
+            return search_data;
+        }
+
+        void AddTrip(const Bus* bus, size_t first, size_t last);
+        // Раунды поиска из source, возвращает номер последнего раунда. Прибытия позже, чем
+        // в target (без отсечения при target = NO_STOP) или чем max_arrival, не рассматриваются
+        size_t RunRounds(SearchData& data, uint32_t source, uint32_t target, double max_arrival) const;
+        // Маршрут до target по меткам раунда round и предыдущих
+        Route ExtractRoute(const SearchData& data, uint32_t source, uint32_t target, size_t round) const;
+
+        double bus_wait_time_ = 0;
+        double bus_speed_ = 0;
+        std::vector<const Stop*> stops_;
+        std::unordered_map<const Stop*, uint32_t> stop_indices_;
+        std::vector<Trip> trips_;
+        // Остановки всех рейсов подряд и расстояние от начала рейса до каждой из них
+        std::vector<uint32_t> trip_stops_;
+        std::vector<int> trip_distances_;
+        // Рейсы через каждую остановку: [stop_trip_offsets_[s], stop_trip_offsets_[s + 1])
+        std::vector<size_t> stop_trip_offsets_;
+        std::vector<StopTrip> stop_trips_;
+    };
+
+} // namespace transport
@@ -1,5 +1,8 @@
 #include "request_handler.h"
+#include "min_plus.h"
 
+#include <algorithm>
+#include <limits>
 #include <utility>
 #include <sstream>
 #include <unordered_set>
@@ -8,6 +11,15 @@ using namespace std;
 using namespace transport;
 using namespace domain;
 
+namespace {
+
+    // Счетчики size_t в JSON-числе int: значения больше INT_MAX выводятся как INT_MAX
+    int ClampToInt(size_t value) {
+        return static_cast<int>(min(value, static_cast<size_t>(numeric_limits<int>::max())));
+    }
+
+} // namespace
+
 RequestHandler::RequestHandler(const transport::Catalogue& catalogue,
     const transport::Router& router, const renderer::MapRenderer& renderer)
     : db_(catalogue)
@@ -37,6 +49,22 @@ void RequestHandler::JsonStatRequests(const json::Node& json_input, std::ostream
             output_array.push_back(BuildRouteRequestProcessing(request_map));
             continue;
         }
+        if (type == "RouteMatrix"s) {
+            output_array.push_back(BuildRouteMatrixRequestProcessing(request_map));
+            continue;
+        }
+        if (type == "ParetoRoute"s) {
+            output_array.push_back(BuildParetoRouteRequestProcessing(request_map));
+            continue;
+        }
+        if (type == "Isochrone"s) {
+            output_array.push_back(BuildIsochroneRequestProcessing(request_map));
+            continue;
+        }
+        if (type == "RouterStats"s) {
+            output_array.push_back(RouterStatsRequestProcessing(request_map));
+            continue;
+        }
     }
     json::Print(json::Document(json::Node(move(output_array))), output);
 }
@@ -113,15 +141,18 @@ json::Node RequestHandler::BuildMapRequestProcessing(const json::Dict& request_m
 }
 
 json::Node RequestHandler::BuildRouteRequestProcessing(const json::Dict& request_map) {
+    if (request_map.count("via"s)) {
+        return BuildViaRouteRequestProcessing(request_map);
+    }
     int id = request_map.at("id"s).AsInt();
     const string& name_from = request_map.at("from"s).AsString();
     const string& name_to = request_map.at("to"s).AsString();
     if (const Stop* stop_from = db_.FindStop(name_from)) {
         if (const Stop* stop_to = db_.FindStop(name_to)) {
-            if (auto ri = router_.GetRouteInfo(stop_from, stop_to)) {
-                auto [wieght, edges] = ri.value();
+            if (auto ri = router_.GetRouteItems(stop_from, stop_to)) {
+                auto& [wieght, items] = ri.value();
                 return json::Node(json::Dict{
-                    {{"items"s},{router_.GetEdgesItems(edges)}},
+                    {{"items"s},{std::move(items)}},
                     {{"total_time"s},{wieght}},
                     {{"request_id"s},{id}}
                     });
@@ -133,3 +164,159 @@ json::Node RequestHandler::BuildRouteRequestProcessing(const json::Dict& request
         .Key("request_id"s).Value(id)
         .EndDict().Build();
 }
+
+json::Node RequestHandler::BuildViaRouteRequestProcessing(const json::Dict& request_map) {
+    int id = request_map.at("id"s).AsInt();
+    const json::Array& via_names = request_map.at("via"s).AsArray();
+    vector<const Stop*> stops;
+    stops.reserve(via_names.size() + 2);
+    stops.push_back(db_.FindStop(request_map.at("from"s).AsString()));
+    for (const auto& name : via_names) {
+        stops.push_back(db_.FindStop(name.AsString()));
+    }
+    stops.push_back(db_.FindStop(request_map.at("to"s).AsString()));
+
+    optional<RouteItems> route;
+    if (find(stops.begin(), stops.end(), nullptr) == stops.end()) {
+        route = router_.GetViaRouteItems(stops);
+    }
+    if (!route) {
+        return json::Builder{}.StartDict()
+            .Key("error_message"s).Value("not found"s)
+            .Key("request_id"s).Value(id)
+            .EndDict().Build();
+    }
+    return json::Node(json::Dict{
+        {{"items"s},{std::move(route->items)}},
+        {{"total_time"s},{route->total_time}},
+        {{"request_id"s},{id}}
+        });
+}
+
+json::Node RequestHandler::BuildRouteMatrixRequestProcessing(const json::Dict& request_map) {
+    int id = request_map.at("id"s).AsInt();
+    auto find_stops = [this](const json::Array& names) {
+        vector<const Stop*> stops;
+        stops.reserve(names.size());
+        for (const auto& name : names) {
+            const Stop* stop = db_.FindStop(name.AsString());
+            if (!stop) {
+                return vector<const Stop*>{};
+            }
+            stops.push_back(stop);
+        }
+        return stops;
+    };
+    const json::Array& names_from = request_map.at("from"s).AsArray();
+    const json::Array& names_to = request_map.at("to"s).AsArray();
+    const vector<const Stop*> stops_from = find_stops(names_from);
+    const vector<const Stop*> stops_to = find_stops(names_to);
+    if (stops_from.size() != names_from.size() || stops_to.size() != names_to.size()) {
+        return json::Builder{}.StartDict()
+            .Key("error_message"s).Value("not found"s)
+            .Key("request_id"s).Value(id)
+            .EndDict().Build();
+    }
+
+    json::Array times_array;
+    times_array.reserve(stops_from.size());
+    for (const auto& row : router_.GetRouteMatrix(stops_from, stops_to)) {
+        json::Array row_array;
+        row_array.reserve(row.size());
+        for (const auto& total_time : row) {
+            row_array.push_back(total_time ? json::Node(*total_time) : json::Node());
+        }
+        times_array.push_back(move(row_array));
+    }
+    return json::Node(json::Dict{
+        {{"request_id"s},{id}},
+        {{"total_times"s},{move(times_array)}}
+        });
+}
+
+json::Node RequestHandler::BuildParetoRouteRequestProcessing(const json::Dict& request_map) {
+    int id = request_map.at("id"s).AsInt();
+    const Stop* stop_from = db_.FindStop(request_map.at("from"s).AsString());
+    const Stop* stop_to = db_.FindStop(request_map.at("to"s).AsString());
+    size_t max_transfers = numeric_limits<uint32_t>::max();
+    if (request_map.count("max_transfers"s)) {
+        max_transfers = static_cast<size_t>(max(0, request_map.at("max_transfers"s).AsInt()));
+    }
+    vector<ParetoRouteItems> routes;
+    if (stop_from && stop_to) {
+        routes = router_.GetParetoRoutes(stop_from, stop_to, max_transfers);
+    }
+    if (routes.empty()) {
+        return json::Builder{}.StartDict()
+            .Key("error_message"s).Value("not found"s)
+            .Key("request_id"s).Value(id)
+            .EndDict().Build();
+    }
+
+    json::Array routes_array;
+    routes_array.reserve(routes.size());
+    for (auto& [transfer_count, route] : routes) {
+        routes_array.push_back(json::Node(json::Dict{
+            {{"items"s},{std::move(route.items)}},
+            {{"total_time"s},{route.total_time}},
+            {{"transfer_count"s},{ClampToInt(transfer_count)}}
+            }));
+    }
+    return json::Builder{}.StartDict()
+        .Key("request_id"s).Value(id)
+        .Key("routes"s).Value(move(routes_array))
+        .EndDict().Build();
+}
+
+json::Node RequestHandler::BuildIsochroneRequestProcessing(const json::Dict& request_map) {
+    int id = request_map.at("id"s).AsInt();
+    const Stop* stop_from = db_.FindStop(request_map.at("from"s).AsString());
+    if (!stop_from) {
+        return json::Builder{}.StartDict()
+            .Key("error_message"s).Value("not found"s)
+            .Key("request_id"s).Value(id)
+            .EndDict().Build();
+    }
+
+    json::Array stops_array;
+    for (const auto& [stop_name, time] : router_.GetReachableStops(stop_from, request_map.at("max_time"s).AsDouble())) {
+        stops_array.push_back(json::Builder{}.StartDict()
+            .Key("stop_name"s).Value(string(stop_name))
+            .Key("time"s).Value(time)
+            .EndDict().Build());
+    }
+    return json::Builder{}.StartDict()
+        .Key("request_id"s).Value(id)
+        .Key("stops"s).Value(move(stops_array))
+        .EndDict().Build();
+}
+
+json::Node RequestHandler::RouterStatsRequestProcessing(const json::Dict& request_map) {
+    int id = request_map.at("id"s).AsInt();
+    const cache::CacheStats route_cache_stats = router_.GetRouteCacheStats();
+    const graph::SearchStats search_stats = router_.GetSearchStats();
+    const graph::SearchStats pareto_search_stats = router_.GetParetoSearchStats();
+    const transport::RoutingUpdateStats update_stats = router_.GetUpdateStats();
+    return json::Builder{}.StartDict()
+        .Key("min_plus_kernel"s).Value(string(graph::GetMinPlusKernelName()))
+        .Key("pareto_search"s).StartDict()
+            .Key("searches"s).Value(ClampToInt(pareto_search_stats.searches))
+            .Key("settled_vertices"s).Value(ClampToInt(pareto_search_stats.settled_vertices))
+        .EndDict()
+        .Key("route_cache"s).StartDict()
+            .Key("capacity"s).Value(ClampToInt(route_cache_stats.capacity))
+            .Key("hits"s).Value(ClampToInt(route_cache_stats.hits))
+            .Key("misses"s).Value(ClampToInt(route_cache_stats.misses))
+            .Key("size"s).Value(ClampToInt(route_cache_stats.size))
+        .EndDict()
+        .Key("request_id"s).Value(id)
+        .Key("search"s).StartDict()
+            .Key("searches"s).Value(ClampToInt(search_stats.searches))
+            .Key("settled_vertices"s).Value(ClampToInt(search_stats.settled_vertices))
+        .EndDict()
+        .Key("updates"s).StartDict()
+            .Key("repaired_rows"s).Value(ClampToInt(update_stats.repaired_rows))
+            .Key("updated_edges"s).Value(ClampToInt(update_stats.updated_edges))
+        .EndDict()
+        .EndDict().Build();
+}
@@ -31,4 +31,14 @@ private:
     json::Node FindBusRequestProcessing(const json::Dict& request_map);
     json::Node BuildMapRequestProcessing(const json::Dict& request_map);
     json::Node BuildRouteRequestProcessing(const json::Dict& request_map);
+    // Маршрут из "from" в "to" через остановки "via" по порядку - запрос Route с ключом "via"
+    json::Node BuildViaRouteRequestProcessing(const json::Dict& request_map);
+    // Матрица времени маршрутов между списками остановок "from" и "to", null - маршрута нет
+    json::Node BuildRouteMatrixRequestProcessing(const json::Dict& request_map);
+    // Самые быстрые маршруты из "from" в "to" для каждого числа пересадок (не больше "max_transfers")
+    json::Node BuildParetoRouteRequestProcessing(const json::Dict& request_map);
+    // Остановки, до которых можно доехать из "from" не дольше "max_time" минут, и время до них
+    json::Node BuildIsochroneRequestProcessing(const json::Dict& request_map);
+    // Счетчики роутера для подбора настроек, например емкости кэша маршрутов
+    json::Node RouterStatsRequestProcessing(const json::Dict& request_map);
 };
@@ -1,13 +1,23 @@
 #pragma once
 
+#include "fixed_weight.h"
 #include "graph.h"
+#include "mapped_file.h"
+#include "min_plus.h"
+#include "page_allocator.h"
 
 #include <algorithm>
 #include <cassert>
+#include <condition_variable>
 #include <cstdint>
+#include <cstring>
 #include <iterator>
+#include <limits>
+#include <mutex>
 #include <optional>
 #include <stdexcept>
+#include <string>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -15,107 +25,501 @@
 namespace graph {
 
     template <typename Weight>
+    struct RouteInfo {
+        Weight weight;
+        std::vector<EdgeId> edges;
+    };
+
+    // Таблица маршрутов всех пар вершин в плоском виде: строка на каждую вершину отправления,
+    // веса и предыдущие ребра хранятся в отдельных непрерывных массивах.
+    // Отсутствие маршрута - бесконечный вес, отсутствие предыдущего ребра - NO_EDGE.
+    // Массивы выделяются страницами режима, заданного при создании (storage::PageMode)
+    template <typename Weight>
+    struct RoutesTable {
+        static constexpr uint32_t NO_EDGE = std::numeric_limits<uint32_t>::max();
+        static constexpr Weight NO_ROUTE = std::numeric_limits<Weight>::infinity();
+
+        template <typename T>
+        using Vector = std::vector<T, storage::PageAllocator<T>>;
+
+        RoutesTable() = default;
+        explicit RoutesTable(storage::PageMode page_mode)
+            : weights(storage::PageAllocator<Weight>(page_mode))
+            , prev_edges(storage::PageAllocator<uint32_t>(page_mode)) {}
+
+        size_t vertex_count = 0;
+        Vector<Weight> weights;
+        Vector<uint32_t> prev_edges;
+    };
+
+    // Заголовок файла таблицы маршрутов. За ним веса (weight_size байт, weight_scale - масштаб
+    // весов фиксированной точки или 0) и последние ребра (uint32) построчно, как в RoutesTable,
+    // в порядке байтов машины. edge_count и graph_hash позволяют убедиться, что файл рассчитан
+    // для того же графа
+    struct RoutesTableFileHeader {
+        static constexpr char MAGIC[8] = { 'T', 'C', 'R', 'O', 'U', 'T', 'E', 'S' };
+        static constexpr uint32_t VERSION = 1;
+
+        char magic[8];
+        uint32_t version;
+        uint32_t weight_size;
+        uint64_t vertex_count;
+        uint64_t edge_count;
+        uint64_t graph_hash;
+        uint32_t weight_scale;
+        char reserved[20];
+    };
+    static_assert(sizeof(RoutesTableFileHeader) == 64);
+
+    template <typename TableWeight>
+    size_t GetRoutesTableFileSize(size_t vertex_count) {
+        return sizeof(RoutesTableFileHeader) + vertex_count * vertex_count * (sizeof(TableWeight) + sizeof(uint32_t));
+    }
+
+    // Хэш FNV-1a концов и весов ребер графа
+    template <typename Weight>
+    uint64_t GetGraphHash(const DirectedWeightedGraph<Weight>& graph) {
+        uint64_t hash = 14695981039346656037ull;
+        auto add_bytes = [&hash](const void* data, size_t size) {
+            const unsigned char* bytes = static_cast<const unsigned char*>(data);
+            for (size_t i = 0; i < size; ++i) {
+                hash = (hash ^ bytes[i]) * 1099511628211ull;
+            }
+        };
+        for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+            const Edge<Weight>& edge = graph.GetEdge(edge_id);
+            add_bytes(&edge.from, sizeof(edge.from));
+            add_bytes(&edge.to, sizeof(edge.to));
+            add_bytes(&edge.weight, sizeof(edge.weight));
+        }
+        return hash;
+    }
+
+    // Изменение весов ребер для обновления строк таблицы маршрутов: строку из вершины нужно
+    // пересчитать, если ее дерево кратчайших путей содержит подорожавшее ребро или если
+    // подешевевшее ребро (u, v) дает путь до v короче записанного в строке
+    template <typename Weight>
+    class EdgeWeightChanges {
+
+    public:
+
+        EdgeWeightChanges(const DirectedWeightedGraph<Weight>& graph,
+            const std::vector<std::pair<EdgeId, Weight>>& old_weights)
+            : graph_(graph)
+            , is_increased_(graph.GetEdgeCount(), false) {
+            for (const auto& [edge_id, old_weight] : old_weights) {
+                const Weight new_weight = graph.GetEdge(edge_id).weight;
+                if (new_weight < Weight{}) {
+                    throw std::domain_error("Edges' weights should be non-negative");
+                }
+                if (old_weight < new_weight) {
+                    is_increased_[edge_id] = true;
+                }
+                else if (new_weight < old_weight) {
+                    decreased_edges_.push_back(edge_id);
+                }
+            }
+        }
+
+        template <typename TableWeight>
+        bool IsRowAffected(const TableWeight* weights_row, const uint32_t* prev_edges_row, size_t vertex_count) const {
+            for (const EdgeId edge_id : decreased_edges_) {
+                const auto& edge = graph_.GetEdge(edge_id);
+                if (weights_row[edge.from] == std::numeric_limits<TableWeight>::infinity()) {
+                    continue;
+                }
+                if (static_cast<Weight>(weights_row[edge.from]) + edge.weight < static_cast<Weight>(weights_row[edge.to])) {
+                    return true;
+                }
+            }
+            for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+                const uint32_t prev_edge = prev_edges_row[vertex];
+                if (prev_edge != RoutesTable<TableWeight>::NO_EDGE && is_increased_[prev_edge]) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+    private:
+
+        const DirectedWeightedGraph<Weight>& graph_;
+        std::vector<char> is_increased_;
+        std::vector<EdgeId> decreased_edges_;
+    };
+
+    // Точка синхронизации потоков: Wait возвращается, когда его вызвали все count потоков
+    class ThreadBarrier {
+
+    public:
+
+        explicit ThreadBarrier(size_t count)
+            : count_(count) {}
+
+        void Wait() {
+            std::unique_lock lock(mutex_);
+            const size_t generation = generation_;
+            if (++waiting_ == count_) {
+                waiting_ = 0;
+                ++generation_;
+                condition_.notify_all();
+            }
+            else {
+                condition_.wait(lock, [this, generation] { return generation != generation_; });
+            }
+        }
+
+    private:
+
+        std::mutex mutex_;
+        std::condition_variable condition_;
+        const size_t count_;
+        size_t waiting_ = 0;
+        size_t generation_ = 0;
+    };
+
+    // TableWeight - тип весов в таблице. При TableWeight = float или FixedTime таблица занимает меньше
+    // памяти, а вес найденного маршрута пересчитывается по ребрам графа в исходном типе Weight.
+    // Таблица хранится в памяти или читается из файла, отображенного в память
+    template <typename Weight, typename TableWeight = Weight>
     class Router {
 
     private:
 
         using Graph = DirectedWeightedGraph<Weight>;
+        using Table = RoutesTable<TableWeight>;
+
+        static_assert(std::numeric_limits<TableWeight>::has_infinity,
+            "Routes table weight should have infinity value");
 
     public:
 
-        explicit Router(const Graph& graph);
+        // thread_count - число потоков для расчета таблицы (0 - по числу ядер),
+        // page_mode - страницы памяти таблицы
+        explicit Router(const Graph& graph, size_t thread_count = 1,
+            storage::PageMode page_mode = storage::PageMode::DEFAULT);
+        // Восстановление ранее рассчитанной таблицы без повторного расчета
+        Router(const Graph& graph, Table routes_table);
+        // Таблица из файла path, записанного WriteRoutesTableFile: файл отображается в память,
+        // с диска читаются только строки, к которым были запросы
+        Router(const Graph& graph, const std::string& path);
+        Router(const Router&) = delete;
+        Router& operator=(const Router&) = delete;
 
-        struct RouteInfo {
-            Weight weight;
-            std::vector<EdgeId> edges;
-        };
+        // Расчет таблицы по строкам build_row(from, weights, prev_edges) (в формате RoutesTable
+        // с весами Weight) прямо в файл path, без хранения таблицы в памяти.
+        // build_row вызывается из thread_count потоков одновременно (0 - по числу ядер)
+        template <typename BuildRow>
+        static void WriteRoutesTableFile(const Graph& graph, const std::string& path, BuildRow build_row,
+            size_t thread_count = 1);
+
+        using RouteInfo = graph::RouteInfo<Weight>;
 
         std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+        // Вес маршрута прямо из таблицы, без восстановления ребер
+        std::optional<Weight> GetRouteWeight(VertexId from, VertexId to) const;
+        // Таблица в памяти (пустая, если таблица читается из файла)
+        const Table& GetRoutesTable() const;
+        // Обновление таблицы после смены весов ребер графа (old_weights - прежние веса):
+        // затронутые строки пересчитываются build_row(from, weights, prev_edges) в формате
+        // RoutesTable с весами Weight. Возвращает число пересчитанных строк.
+        // Строки таблицы из файла меняются только в памяти процесса, файл остается прежним
+        template <typename BuildRow>
+        size_t RepairRoutes(const std::vector<std::pair<EdgeId, Weight>>& old_weights, BuildRow build_row);
 
     private:
 
-        struct RouteInternalData {
-            Weight weight;
-            std::optional<EdgeId> prev_edge;
-        };
-
-        using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
-
-        void InitializeRoutesInternalData(const Graph& graph) {
+        void InitializeRoutesInternalData(const Graph& graph, storage::PageMode page_mode) {
             const size_t vertex_count = graph.GetVertexCount();
+            if (graph.GetEdgeCount() >= Table::NO_EDGE) {
+                throw std::length_error("Too many edges for routes table");
+            }
+            routes_table_ = Table(page_mode);
+            routes_table_.vertex_count = vertex_count;
+            routes_table_.weights.assign(vertex_count * vertex_count, Table::NO_ROUTE);
+            routes_table_.prev_edges.assign(vertex_count * vertex_count, Table::NO_EDGE);
+            SetTableData(vertex_count, routes_table_.weights.data(), routes_table_.prev_edges.data());
+
             for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
-                routes_internal_data_[vertex][vertex] = RouteInternalData{ ZERO_WEIGHT, std::nullopt };
+                TableWeight* weights_row = &weights_[vertex * vertex_count];
+                uint32_t* prev_edges_row = &prev_edges_[vertex * vertex_count];
+                weights_row[vertex] = ZERO_WEIGHT;
                 for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
                     const auto& edge = graph.GetEdge(edge_id);
-                    if (edge.weight < ZERO_WEIGHT) {
+                    if (edge.weight < Weight{}) {
                         throw std::domain_error("Edges' weights should be non-negative");
                     }
-                    auto& route_internal_data = routes_internal_data_[vertex][edge.to];
-                    if (!route_internal_data || route_internal_data->weight > edge.weight) {
-                        route_internal_data = RouteInternalData{ edge.weight, edge_id };
+                    const TableWeight edge_weight = static_cast<TableWeight>(edge.weight);
+                    if (weights_row[edge.to] > edge_weight) {
+                        weights_row[edge.to] = edge_weight;
+                        prev_edges_row[edge.to] = static_cast<uint32_t>(edge_id);
                     }
                 }
             }
         }
 
-        void RelaxRoute(VertexId vertex_from, VertexId vertex_to, const RouteInternalData& route_from,
-            const RouteInternalData& route_to) {
-            auto& route_relaxing = routes_internal_data_[vertex_from][vertex_to];
-            const Weight candidate_weight = route_from.weight + route_to.weight;
-            if (!route_relaxing || candidate_weight < route_relaxing->weight) {
-                route_relaxing = { candidate_weight,
-                                  route_to.prev_edge ? route_to.prev_edge : route_from.prev_edge };
+        // Строки vertex_from на шаге vertex_through независимы друг от друга: сама строка vertex_through
+        // и столбец vertex_through на этом шаге не меняются, так как веса неотрицательны. Строка
+        // vertex_through пропускается - ее читают остальные потоки, а через себя она не улучшается.
+        // Поэтому строки можно делить между потоками, а результат совпадает с однопоточным до бита.
+        // В строке vertex_through нет последнего ребра только у недостижимых вершин и у самой
+        // vertex_through с нулевым весом - через них строка не улучшается, поэтому последнее ребро
+        // всегда берется из строки vertex_through и строку можно релаксировать векторно
+        void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through,
+            VertexId vertex_from_begin, VertexId vertex_from_end) {
+            const TableWeight* through_weights = &weights_[vertex_through * vertex_count];
+            const uint32_t* through_prev_edges = &prev_edges_[vertex_through * vertex_count];
+            for (VertexId vertex_from = vertex_from_begin; vertex_from < vertex_from_end; ++vertex_from) {
+                if (vertex_from == vertex_through) {
+                    continue;
+                }
+                TableWeight* weights_row = &weights_[vertex_from * vertex_count];
+                const TableWeight weight_from = weights_row[vertex_through];
+                if (weight_from == Table::NO_ROUTE) {
+                    continue;
+                }
+                RelaxRowMinPlus(weights_row, &prev_edges_[vertex_from * vertex_count], through_weights,
+                    through_prev_edges, weight_from, vertex_count);
             }
         }
 
-        void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through) {
-            for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
-                if (const auto& route_from = routes_internal_data_[vertex_from][vertex_through]) {
-                    for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
-                        if (const auto& route_to = routes_internal_data_[vertex_through][vertex_to]) {
-                            RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
-                        }
-                    }
+        void ComputeRoutesInternalData(size_t thread_count) {
+            const size_t vertex_count = vertex_count_;
+            thread_count = GetThreadCount(thread_count, vertex_count);
+
+            if (thread_count == 1) {
+                for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
+                    RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through, 0, vertex_count);
                 }
+                return;
+            }
+
+            // Каждый поток обрабатывает свою полосу строк, после каждого шага - общая синхронизация
+            ThreadBarrier barrier(thread_count);
+            auto relax_rows = [this, &barrier, vertex_count, thread_count](size_t thread_index) {
+                const VertexId vertex_from_begin = vertex_count * thread_index / thread_count;
+                const VertexId vertex_from_end = vertex_count * (thread_index + 1) / thread_count;
+                for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
+                    RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through,
+                        vertex_from_begin, vertex_from_end);
+                    barrier.Wait();
+                }
+            };
+
+            std::vector<std::thread> threads;
+            threads.reserve(thread_count - 1);
+            for (size_t thread_index = 1; thread_index < thread_count; ++thread_index) {
+                threads.emplace_back(relax_rows, thread_index);
+            }
+            relax_rows(0);
+            for (auto& thread : threads) {
+                thread.join();
+            }
+        }
+
+        void SetTableData(size_t vertex_count, TableWeight* weights, uint32_t* prev_edges) {
+            vertex_count_ = vertex_count;
+            weights_ = weights;
+            prev_edges_ = prev_edges;
+        }
+
+        // Число потоков расчета: 0 - по числу ядер, но не больше чем по MIN_ROWS_PER_THREAD строк на поток
+        static size_t GetThreadCount(size_t thread_count, size_t vertex_count) {
+            if (thread_count == 0) {
+                thread_count = std::max<size_t>(std::thread::hardware_concurrency(), 1);
             }
+            return std::max<size_t>(std::min(thread_count, vertex_count / MIN_ROWS_PER_THREAD), 1);
         }
 
-        static constexpr Weight ZERO_WEIGHT{};
+        static constexpr size_t MIN_ROWS_PER_THREAD = 64;
+        static constexpr TableWeight ZERO_WEIGHT{};
         const Graph& graph_;
-        RoutesInternalData routes_internal_data_;
+        Table routes_table_;
+        std::optional<storage::MappedFile> mapped_file_;
+        // Строки таблицы: в routes_table_ или в mapped_file_
+        size_t vertex_count_ = 0;
+        TableWeight* weights_ = nullptr;
+        uint32_t* prev_edges_ = nullptr;
     };
 
-    template <typename Weight>
-    Router<Weight>::Router(const Graph& graph)
+    template <typename Weight, typename TableWeight>
+    Router<Weight, TableWeight>::Router(const Graph& graph, size_t thread_count, storage::PageMode page_mode)
         : graph_(graph)
-        , routes_internal_data_(graph.GetVertexCount(),
-            std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount()))
     {
-        InitializeRoutesInternalData(graph);
+        InitializeRoutesInternalData(graph, page_mode);
+        ComputeRoutesInternalData(thread_count);
+    }
 
+    template <typename Weight, typename TableWeight>
+    Router<Weight, TableWeight>::Router(const Graph& graph, Table routes_table)
+        : graph_(graph)
+        , routes_table_(std::move(routes_table))
+    {
         const size_t vertex_count = graph.GetVertexCount();
-        for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
-            RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
+        if (routes_table_.vertex_count != vertex_count
+            || routes_table_.weights.size() != vertex_count * vertex_count
+            || routes_table_.prev_edges.size() != vertex_count * vertex_count) {
+            throw std::invalid_argument("Routes table doesn't match the graph");
+        }
+        for (const uint32_t prev_edge : routes_table_.prev_edges) {
+            if (prev_edge != Table::NO_EDGE && prev_edge >= graph.GetEdgeCount()) {
+                throw std::invalid_argument("Routes table refers to unknown edge");
+            }
         }
+        SetTableData(vertex_count, routes_table_.weights.data(), routes_table_.prev_edges.data());
     }
 
-    template <typename Weight>
-    std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
-        VertexId to) const {
-        const auto& route_internal_data = routes_internal_data_.at(from).at(to);
-        if (!route_internal_data) {
+    template <typename Weight, typename TableWeight>
+    Router<Weight, TableWeight>::Router(const Graph& graph, const std::string& path)
+        : graph_(graph)
+        , mapped_file_(storage::MappedFile::Open(path))
+    {
+        // Ребра таблицы не проверяются: это прочитало бы весь файл, совпадение графа проверяет хэш
+        const size_t vertex_count = graph.GetVertexCount();
+        RoutesTableFileHeader header;
+        if (mapped_file_->GetSize() < sizeof(header)) {
+            throw std::invalid_argument("Routes table file is broken");
+        }
+        std::memcpy(&header, mapped_file_->GetData(), sizeof(header));
+        if (std::memcmp(header.magic, RoutesTableFileHeader::MAGIC, sizeof(header.magic)) != 0
+            || header.version != RoutesTableFileHeader::VERSION
+            || header.weight_size != sizeof(TableWeight)
+            || header.weight_scale != WeightScale<TableWeight>::value
+            || mapped_file_->GetSize() != GetRoutesTableFileSize<TableWeight>(vertex_count)) {
+            throw std::invalid_argument("Routes table file is broken");
+        }
+        if (header.vertex_count != vertex_count || header.edge_count != graph.GetEdgeCount()
+            || header.graph_hash != GetGraphHash(graph)) {
+            throw std::invalid_argument("Routes table file doesn't match the graph");
+        }
+
+        std::byte* weights = mapped_file_->GetData() + sizeof(header);
+        std::byte* prev_edges = weights + vertex_count * vertex_count * sizeof(TableWeight);
+        SetTableData(vertex_count, reinterpret_cast<TableWeight*>(weights), reinterpret_cast<uint32_t*>(prev_edges));
+    }
+
+    template <typename Weight, typename TableWeight>
+    template <typename BuildRow>
+    void Router<Weight, TableWeight>::WriteRoutesTableFile(const Graph& graph, const std::string& path,
+        BuildRow build_row, size_t thread_count) {
+        const size_t vertex_count = graph.GetVertexCount();
+        if (graph.GetEdgeCount() >= Table::NO_EDGE) {
+            throw std::length_error("Too many edges for routes table");
+        }
+        storage::MappedFile file = storage::MappedFile::Create(path, GetRoutesTableFileSize<TableWeight>(vertex_count));
+
+        RoutesTableFileHeader header{};
+        std::memcpy(header.magic, RoutesTableFileHeader::MAGIC, sizeof(header.magic));
+        header.version = RoutesTableFileHeader::VERSION;
+        header.weight_size = sizeof(TableWeight);
+        header.weight_scale = WeightScale<TableWeight>::value;
+        header.vertex_count = vertex_count;
+        header.edge_count = graph.GetEdgeCount();
+        header.graph_hash = GetGraphHash(graph);
+        TableWeight* weights = reinterpret_cast<TableWeight*>(file.GetData() + sizeof(header));
+        uint32_t* prev_edges = reinterpret_cast<uint32_t*>(weights + vertex_count * vertex_count);
+
+        // Строки независимы, каждый поток пишет свою полосу строк
+        thread_count = GetThreadCount(thread_count, vertex_count);
+        auto write_rows = [&build_row, weights, prev_edges, vertex_count, thread_count](size_t thread_index) {
+            std::vector<Weight> row_weights;
+            std::vector<uint32_t> row_prev_edges;
+            const VertexId vertex_from_begin = vertex_count * thread_index / thread_count;
+            const VertexId vertex_from_end = vertex_count * (thread_index + 1) / thread_count;
+            for (VertexId vertex_from = vertex_from_begin; vertex_from < vertex_from_end; ++vertex_from) {
+                build_row(vertex_from, row_weights, row_prev_edges);
+                std::transform(row_weights.begin(), row_weights.end(), weights + vertex_from * vertex_count,
+                    [](Weight weight) { return static_cast<TableWeight>(weight); });
+                std::copy(row_prev_edges.begin(), row_prev_edges.end(), prev_edges + vertex_from * vertex_count);
+            }
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve(thread_count - 1);
+        for (size_t thread_index = 1; thread_index < thread_count; ++thread_index) {
+            threads.emplace_back(write_rows, thread_index);
+        }
+        write_rows(0);
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        // Заголовок записывается последним: до него файл начинается с нулей и не проходит проверку,
+        // поэтому прерванная запись не оставляет таблицу, которую примут за целую
+        std::memcpy(file.GetData(), &header, sizeof(header));
+    }
+
+    template <typename Weight, typename TableWeight>
+    const RoutesTable<TableWeight>& Router<Weight, TableWeight>::GetRoutesTable() const {
+        return routes_table_;
+    }
+
+    template <typename Weight, typename TableWeight>
+    template <typename BuildRow>
+    size_t Router<Weight, TableWeight>::RepairRoutes(const std::vector<std::pair<EdgeId, Weight>>& old_weights,
+        BuildRow build_row) {
+        const size_t vertex_count = vertex_count_;
+        const EdgeWeightChanges<Weight> changes(graph_, old_weights);
+        std::vector<VertexId> affected_rows;
+        for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
+            if (changes.IsRowAffected(&weights_[vertex_from * vertex_count],
+                &prev_edges_[vertex_from * vertex_count], vertex_count)) {
+                affected_rows.push_back(vertex_from);
+            }
+        }
+
+        std::vector<Weight> weights;
+        std::vector<uint32_t> prev_edges;
+        for (const VertexId vertex_from : affected_rows) {
+            build_row(vertex_from, weights, prev_edges);
+            std::transform(weights.begin(), weights.end(), weights_ + vertex_from * vertex_count,
+                [](Weight weight) { return static_cast<TableWeight>(weight); });
+            std::copy(prev_edges.begin(), prev_edges.end(), prev_edges_ + vertex_from * vertex_count);
+        }
+        return affected_rows.size();
+    }
+
+    template <typename Weight, typename TableWeight>
+    std::optional<Weight> Router<Weight, TableWeight>::GetRouteWeight(VertexId from, VertexId to) const {
+        const size_t vertex_count = vertex_count_;
+        if (from >= vertex_count || to >= vertex_count) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+        const TableWeight weight = weights_[from * vertex_count + to];
+        if (weight == Table::NO_ROUTE) {
             return std::nullopt;
         }
-        const Weight weight = route_internal_data->weight;
+        return static_cast<Weight>(weight);
+    }
+
+    template <typename Weight, typename TableWeight>
+    std::optional<typename Router<Weight, TableWeight>::RouteInfo> Router<Weight, TableWeight>::BuildRoute(
+        VertexId from, VertexId to) const {
+        const size_t vertex_count = vertex_count_;
+        if (from >= vertex_count || to >= vertex_count) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+        const TableWeight* weights_row = &weights_[from * vertex_count];
+        const uint32_t* prev_edges_row = &prev_edges_[from * vertex_count];
+        if (weights_row[to] == Table::NO_ROUTE) {
+            return std::nullopt;
+        }
+
         std::vector<EdgeId> edges;
-        for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
-            edge_id;
-            edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge)
+        for (uint32_t edge_id = prev_edges_row[to];
+            edge_id != Table::NO_EDGE;
+            edge_id = prev_edges_row[graph_.GetEdge(edge_id).from])
         {
-            edges.push_back(*edge_id);
+            edges.push_back(edge_id);
         }
         std::reverse(edges.begin(), edges.end());
 
+        // Вес суммируется по ребрам маршрута по порядку: строки, пересчитанные после изменения весов,
+        // дают тот же вес, что и таблица, построенная заново
+        Weight weight{};
+        for (const EdgeId edge_id : edges) {
+            weight += graph_.GetEdge(edge_id).weight;
+        }
+
         return RouteInfo{ weight, std::move(edges) };
     }
 
@@ -1,5 +1,8 @@
 #include "serialization.h"
 
+#include <cstring>
+#include <type_traits>
+
 using namespace std;
 
 void SerializeCatalogue(const transport::Catalogue& catalogue,
@@ -104,41 +107,96 @@ serialize::RouterSettings GetRouterSettingSerialize(const json::Node& router_set
 
     result.set_bus_wait_time(rs_map.at("bus_wait_time"s).AsInt());
     result.set_bus_velocity(rs_map.at("bus_velocity"s).AsDouble());
+    if (rs_map.count("routing_engine"s)) {
+        result.set_routing_engine(rs_map.at("routing_engine"s).AsString());
+    }
+    if (rs_map.count("routes_table_precision"s)) {
+        result.set_routes_table_precision(rs_map.at("routes_table_precision"s).AsString());
+    }
+    if (rs_map.count("routing_threads"s)) {
+        result.set_routing_threads(rs_map.at("routing_threads"s).AsInt());
+    }
+    if (rs_map.count("graph_model"s)) {
+        result.set_graph_model(rs_map.at("graph_model"s).AsString());
+    }
+    if (rs_map.count("route_cache_size"s)) {
+        result.set_route_cache_size(rs_map.at("route_cache_size"s).AsInt());
+    }
+    if (rs_map.count("route_cache_items"s)) {
+        result.set_route_cache_items(rs_map.at("route_cache_items"s).AsBool());
+    }
+    if (rs_map.count("vertex_order"s)) {
+        result.set_vertex_order(rs_map.at("vertex_order"s).AsString());
+    }
+    if (rs_map.count("huge_pages"s)) {
+        result.set_huge_pages(rs_map.at("huge_pages"s).AsString());
+    }
+    if (rs_map.count("routes_table_file"s)) {
+        result.set_routes_table_file(rs_map.at("routes_table_file"s).AsString());
+    }
 
     return result;
 }
 
 serialize::Graph GetGraphSerialize(const graph::DirectedWeightedGraph<double>& g) {
+    static_assert(std::is_trivially_copyable_v<graph::Edge<double>>);
     serialize::Graph result;
-    size_t vertex_count = g.GetVertexCount();
-    size_t edge_count = g.GetEdgeCount();
 
-    for (size_t i = 0; i < edge_count; ++i) {
-        const graph::Edge<double>& edge = g.GetEdge(i);
-        serialize::Edge s_edge;
+    result.set_vertex_count(g.GetVertexCount());
+    result.set_edge_size(sizeof(graph::Edge<double>));
+    result.mutable_edges()->assign(reinterpret_cast<const char*>(g.GetEdges().data()),
+        g.GetEdgeCount() * sizeof(graph::Edge<double>));
 
-        s_edge.set_name(edge.name);
-        s_edge.set_quality(edge.quality);
-        s_edge.set_from(edge.from);
-        s_edge.set_to(edge.to);
-        s_edge.set_weight(edge.weight);
+    return result;
+}
 
-        *result.add_edge() = s_edge;
-    }
+template <typename TableWeight>
+serialize::RoutesTable GetRoutesTableSerialize(const graph::RoutesTable<TableWeight>& table) {
+    serialize::RoutesTable result;
 
-    for (size_t i = 0; i < vertex_count; ++i) {
-        serialize::Vertex vertex;
+    result.set_vertex_count(table.vertex_count);
+    result.set_weight_size(sizeof(TableWeight));
+    result.set_weight_scale(graph::WeightScale<TableWeight>::value);
+    result.mutable_weights()->assign(reinterpret_cast<const char*>(table.weights.data()),
+        table.weights.size() * sizeof(TableWeight));
+    result.mutable_prev_edges()->assign(reinterpret_cast<const char*>(table.prev_edges.data()),
+        table.prev_edges.size() * sizeof(uint32_t));
 
-        for (const auto& edge_id : g.GetIncidentEdges(i)) {
-            vertex.add_edge_id(edge_id);
-        }
+    return result;
+}
 
-        *result.add_vertex() = vertex;
+serialize::ContractionHierarchy GetContractionHierarchySerialize(const graph::ContractionHierarchy<double>& ch) {
+    serialize::ContractionHierarchy result;
+
+    result.mutable_rank()->Add(ch.ranks.begin(), ch.ranks.end());
+    for (const auto& shortcut : ch.shortcuts) {
+        result.add_shortcut_from(shortcut.from);
+        result.add_shortcut_to(shortcut.to);
+        result.add_shortcut_weight(shortcut.weight);
+        result.add_shortcut_first(shortcut.first);
+        result.add_shortcut_second(shortcut.second);
     }
 
     return result;
 }
 
+serialize::HubLabels GetHubLabelsSerialize(const graph::HubLabels<double>& hub_labels) {
+    using Label = graph::HubLabel<double>;
+    static_assert(std::is_trivially_copyable_v<Label>);
+    serialize::HubLabels result;
+
+    result.set_label_size(sizeof(Label));
+    result.mutable_hub()->Add(hub_labels.hubs.begin(), hub_labels.hubs.end());
+    result.mutable_out_offset()->Add(hub_labels.out_offsets.begin(), hub_labels.out_offsets.end());
+    result.mutable_out_labels()->assign(reinterpret_cast<const char*>(hub_labels.out_labels.data()),
+        hub_labels.out_labels.size() * sizeof(Label));
+    result.mutable_in_offset()->Add(hub_labels.in_offsets.begin(), hub_labels.in_offsets.end());
+    result.mutable_in_labels()->assign(reinterpret_cast<const char*>(hub_labels.in_labels.data()),
+        hub_labels.in_labels.size() * sizeof(Label));
+
+    return result;
+}
+
 serialize::Router Serialize(const transport::Router& router) {
     serialize::Router result;
 
@@ -153,6 +211,23 @@ serialize::Router Serialize(const transport::Router& router) {
 
         *result.add_stop_id() = si;
     }
+    result.mutable_edge_name()->Add(router.GetEdgeNames().begin(), router.GetEdgeNames().end());
+
+    if (const auto* routes_table = router.GetRoutesTable()) {
+        *result.mutable_routes_table() = GetRoutesTableSerialize(*routes_table);
+    }
+    else if (const auto* float_routes_table = router.GetFloatRoutesTable()) {
+        *result.mutable_routes_table() = GetRoutesTableSerialize(*float_routes_table);
+    }
+    else if (const auto* fixed_routes_table = router.GetFixedRoutesTable()) {
+        *result.mutable_routes_table() = GetRoutesTableSerialize(*fixed_routes_table);
+    }
+    if (const auto* contraction_hierarchy = router.GetContractionHierarchy()) {
+        *result.mutable_contraction_hierarchy() = GetContractionHierarchySerialize(*contraction_hierarchy);
+    }
+    if (const auto* hub_labels = router.GetHubLabels()) {
+        *result.mutable_hub_labels() = GetHubLabelsSerialize(*hub_labels);
+    }
 
     return result;
 }
@@ -247,38 +322,44 @@ json::Node GetRenderSettingsFromDB(const serialize::TransportCatalogue& database
 
 json::Node GetRouterSettingsFromDB(const serialize::Router& router) {
     const serialize::RouterSettings& rs = router.router_settings();
-    return json::Node(json::Dict{
+    json::Dict result{
         {{"bus_wait_time"s}, {rs.bus_wait_time()}},
         {{"bus_velocity"s}, {rs.bus_velocity()}}
-        });
+    };
+    if (!rs.routing_engine().empty()) {
+        result["routing_engine"s] = rs.routing_engine();
+    }
+    if (!rs.routes_table_precision().empty()) {
+        result["routes_table_precision"s] = rs.routes_table_precision();
+    }
+    result["routing_threads"s] = rs.routing_threads();
+    if (!rs.graph_model().empty()) {
+        result["graph_model"s] = rs.graph_model();
+    }
+    result["route_cache_size"s] = rs.route_cache_size();
+    result["route_cache_items"s] = rs.route_cache_items();
+    if (!rs.vertex_order().empty()) {
+        result["vertex_order"s] = rs.vertex_order();
+    }
+    if (!rs.huge_pages().empty()) {
+        result["huge_pages"s] = rs.huge_pages();
+    }
+    if (!rs.routes_table_file().empty()) {
+        result["routes_table_file"s] = rs.routes_table_file();
+    }
+    return json::Node(std::move(result));
 }
 
 graph::DirectedWeightedGraph<double> GetGraphFromDB(const serialize::Router& router) {
     const serialize::Graph& g = router.graph();
-    std::vector<graph::Edge<double>> edges(g.edge_size());
-    std::vector<std::vector<graph::EdgeId>> incidence_lists(g.vertex_size());
-
-    for (size_t i = 0; i < edges.size(); ++i) {
-        const serialize::Edge& e = g.edge(i);
-        edges[i] = {
-            e.name(),
-            static_cast<size_t>(e.quality()),
-            static_cast<size_t>(e.from()),
-            static_cast<size_t>(e.to()),
-            e.weight()
-        };
-    }
-
-    for (size_t i = 0; i < incidence_lists.size(); ++i) {
-        const serialize::Vertex& v = g.vertex(i);
-        incidence_lists[i].reserve(v.edge_id_size());
-
-        for (const auto& id : v.edge_id()) {
-            incidence_lists[i].push_back(id);
-        }
+    if (g.edge_size() != sizeof(graph::Edge<double>) || g.edges().size() % sizeof(graph::Edge<double>) != 0) {
+        throw std::runtime_error("Broken graph in database"s);
     }
 
-    return graph::DirectedWeightedGraph<double>(edges, incidence_lists);
+    graph::DirectedWeightedGraph<double>::Edges edges(g.edges().size() / sizeof(graph::Edge<double>));
+    std::memcpy(edges.data(), g.edges().data(), g.edges().size());
+
+    return graph::DirectedWeightedGraph<double>(g.vertex_count(), std::move(edges));
 }
 
 std::map<std::string, graph::VertexId> GetStopIdsFromDB(const serialize::Router& router) {
@@ -291,6 +372,70 @@ std::map<std::string, graph::VertexId> GetStopIdsFromDB(const serialize::Router&
     return result;
 }
 
+template <typename TableWeight>
+graph::RoutesTable<TableWeight> GetRoutesTableFromDB(const serialize::Router& router, storage::PageMode page_mode) {
+    const serialize::RoutesTable& rt = router.routes_table();
+    const size_t cell_count = static_cast<size_t>(rt.vertex_count()) * rt.vertex_count();
+    if (rt.weights().size() != cell_count * sizeof(TableWeight)
+        || rt.prev_edges().size() != cell_count * sizeof(uint32_t)
+        || rt.weight_scale() != graph::WeightScale<TableWeight>::value) {
+        throw std::runtime_error("Broken routes table in database"s);
+    }
+
+    graph::RoutesTable<TableWeight> result(page_mode);
+    result.vertex_count = rt.vertex_count();
+    result.weights.resize(cell_count);
+    result.prev_edges.resize(cell_count);
+    std::memcpy(result.weights.data(), rt.weights().data(), rt.weights().size());
+    std::memcpy(result.prev_edges.data(), rt.prev_edges().data(), rt.prev_edges().size());
+
+    return result;
+}
+
+graph::ContractionHierarchy<double> GetContractionHierarchyFromDB(const serialize::Router& router) {
+    const serialize::ContractionHierarchy& ch = router.contraction_hierarchy();
+    const int shortcut_count = ch.shortcut_from_size();
+    if (ch.shortcut_to_size() != shortcut_count || ch.shortcut_weight_size() != shortcut_count
+        || ch.shortcut_first_size() != shortcut_count || ch.shortcut_second_size() != shortcut_count) {
+        throw std::runtime_error("Broken contraction hierarchy in database"s);
+    }
+
+    graph::ContractionHierarchy<double> result;
+    result.ranks.assign(ch.rank().begin(), ch.rank().end());
+    result.shortcuts.reserve(shortcut_count);
+    for (int i = 0; i < shortcut_count; ++i) {
+        result.shortcuts.push_back({
+            ch.shortcut_from(i),
+            ch.shortcut_to(i),
+            ch.shortcut_weight(i),
+            ch.shortcut_first(i),
+            ch.shortcut_second(i)
+            });
+    }
+
+    return result;
+}
+
+graph::HubLabels<double> GetHubLabelsFromDB(const serialize::Router& router) {
+    using Label = graph::HubLabel<double>;
+    const serialize::HubLabels& hl = router.hub_labels();
+    if (hl.label_size() != sizeof(Label)
+        || hl.out_labels().size() % sizeof(Label) != 0 || hl.in_labels().size() % sizeof(Label) != 0) {
+        throw std::runtime_error("Broken hub labels in database"s);
+    }
+
+    graph::HubLabels<double> result;
+    result.hubs.assign(hl.hub().begin(), hl.hub().end());
+    result.out_offsets.assign(hl.out_offset().begin(), hl.out_offset().end());
+    result.in_offsets.assign(hl.in_offset().begin(), hl.in_offset().end());
+    result.out_labels.resize(hl.out_labels().size() / sizeof(Label));
+    result.in_labels.resize(hl.in_labels().size() / sizeof(Label));
+    std::memcpy(result.out_labels.data(), hl.out_labels().data(), hl.out_labels().size());
+    std::memcpy(result.in_labels.data(), hl.in_labels().data(), hl.in_labels().size());
+
+    return result;
+}
+
 std::tuple<transport::Catalogue, renderer::MapRenderer, transport::Router,
     graph::DirectedWeightedGraph<double>, std::map<std::string, graph::VertexId>>
     Deserialize(std::istream& input) {
@@ -299,6 +444,24 @@ std::tuple<transport::Catalogue, renderer::MapRenderer, transport::Router,
     transport::Catalogue catalogue;
     renderer::MapRenderer renderer(GetRenderSettingsFromDB(database));
     transport::Router router(GetRouterSettingsFromDB(database.router()));
+    if (database.router().has_routes_table()) {
+        if (database.router().routes_table().weight_scale() != 0) {
+            router.SetRoutesTable(GetRoutesTableFromDB<graph::FixedTime>(database.router(), router.GetPageMode()));
+        }
+        else if (database.router().routes_table().weight_size() == sizeof(float)) {
+            router.SetRoutesTable(GetRoutesTableFromDB<float>(database.router(), router.GetPageMode()));
+        }
+        else {
+            router.SetRoutesTable(GetRoutesTableFromDB<double>(database.router(), router.GetPageMode()));
+        }
+    }
+    if (database.router().has_contraction_hierarchy()) {
+        router.SetContractionHierarchy(GetContractionHierarchyFromDB(database.router()));
+    }
+    if (database.router().has_hub_labels()) {
+        router.SetHubLabels(GetHubLabelsFromDB(database.router()));
+    }
+    router.SetEdgeNames({ database.router().edge_name().begin(), database.router().edge_name().end() });
     AddStopFromDB(catalogue, database);
     AddBusFromDB(catalogue, database);
     return { std::move(catalogue), std::move(renderer), std::move(router),
@@ -6,11 +6,390 @@
 #include <utility>
 #include <vector>
 #include <algorithm>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <limits>
+#include <thread>
+#include <unordered_map>
 
 using namespace std;
 
 namespace transport {
 
+    namespace {
+
+        // Погрешность расчета расстояния по прямой, метры
+        constexpr double GEO_DISTANCE_TOLERANCE = 1.0;
+
+        const map<string, RoutingEngine> ROUTING_ENGINES = {
+            {"all_pairs"s, RoutingEngine::ALL_PAIRS},
+            {"dijkstra"s, RoutingEngine::DIJKSTRA},
+            {"a_star"s, RoutingEngine::A_STAR},
+            {"bidirectional_dijkstra"s, RoutingEngine::BIDIRECTIONAL_DIJKSTRA},
+            {"lazy_table"s, RoutingEngine::LAZY_TABLE},
+            {"contraction_hierarchies"s, RoutingEngine::CONTRACTION_HIERARCHIES},
+            {"raptor"s, RoutingEngine::RAPTOR},
+            {"hub_labels"s, RoutingEngine::HUB_LABELS}
+        };
+
+        RoutingEngine ParseRoutingEngine(const string& name) {
+            if (!ROUTING_ENGINES.count(name)) {
+                throw logic_error("Unknown routing engine: "s + name);
+            }
+            return ROUTING_ENGINES.at(name);
+        }
+
+        const string& GetRoutingEngineName(RoutingEngine engine) {
+            auto it = find_if(ROUTING_ENGINES.begin(), ROUTING_ENGINES.end(),
+                [engine](const auto& item) { return item.second == engine; });
+            return it->first;
+        }
+
+        const map<string, GraphModel> GRAPH_MODELS = {
+            {"stop_pairs"s, GraphModel::STOP_PAIRS},
+            {"bus_lines"s, GraphModel::BUS_LINES}
+        };
+
+        GraphModel ParseGraphModel(const string& name) {
+            if (!GRAPH_MODELS.count(name)) {
+                throw logic_error("Unknown graph model: "s + name);
+            }
+            return GRAPH_MODELS.at(name);
+        }
+
+        const map<string, VertexOrder> VERTEX_ORDERS = {
+            {"name"s, VertexOrder::NAME},
+            {"hilbert"s, VertexOrder::HILBERT}
+        };
+
+        VertexOrder ParseVertexOrder(const string& name) {
+            if (!VERTEX_ORDERS.count(name)) {
+                throw logic_error("Unknown vertex order: "s + name);
+            }
+            return VERTEX_ORDERS.at(name);
+        }
+
+        const string& GetVertexOrderName(VertexOrder order) {
+            auto it = find_if(VERTEX_ORDERS.begin(), VERTEX_ORDERS.end(),
+                [order](const auto& item) { return item.second == order; });
+            return it->first;
+        }
+
+        const map<string, storage::PageMode> PAGE_MODES = {
+            {"off"s, storage::PageMode::DEFAULT},
+            {"transparent"s, storage::PageMode::TRANSPARENT_HUGE},
+            {"explicit"s, storage::PageMode::EXPLICIT_HUGE}
+        };
+
+        storage::PageMode ParsePageMode(const string& name) {
+            if (!PAGE_MODES.count(name)) {
+                throw logic_error("Unknown huge pages mode: "s + name);
+            }
+            return PAGE_MODES.at(name);
+        }
+
+        const string& GetPageModeName(storage::PageMode mode) {
+            auto it = find_if(PAGE_MODES.begin(), PAGE_MODES.end(),
+                [mode](const auto& item) { return item.second == mode; });
+            return it->first;
+        }
+
+        const map<string, RoutesTablePrecision> ROUTES_TABLE_PRECISIONS = {
+            {"double"s, RoutesTablePrecision::DOUBLE},
+            {"float"s, RoutesTablePrecision::FLOAT},
+            {"fixed"s, RoutesTablePrecision::FIXED}
+        };
+
+        RoutesTablePrecision ParseRoutesTablePrecision(const string& name) {
+            if (!ROUTES_TABLE_PRECISIONS.count(name)) {
+                throw logic_error("Unknown routes table precision: "s + name);
+            }
+            return ROUTES_TABLE_PRECISIONS.at(name);
+        }
+
+        const string& GetRoutesTablePrecisionName(RoutesTablePrecision precision) {
+            auto it = find_if(ROUTES_TABLE_PRECISIONS.begin(), ROUTES_TABLE_PRECISIONS.end(),
+                [precision](const auto& item) { return item.second == precision; });
+            return it->first;
+        }
+
+        const string& GetGraphModelName(GraphModel model) {
+            auto it = find_if(GRAPH_MODELS.begin(), GRAPH_MODELS.end(),
+                [model](const auto& item) { return item.second == model; });
+            return it->first;
+        }
+
+        // Рейсы автобуса - отрезки [first, last] списка остановок без пересадки: кольцевой целиком,
+        // некольцевой до конечной и обратно
+        vector<pair<size_t, size_t>> GetBusTrips(const Bus& bus) {
+            const size_t stops_count = bus.stops.size();
+            vector<pair<size_t, size_t>> result;
+            if (stops_count < 2) {
+                return result;
+            }
+            if (bus.is_circle) {
+                result.push_back({ 0, stops_count - 1 });
+            }
+            else {
+                result.push_back({ 0, stops_count / 2 });
+                if (stops_count / 2 < stops_count - 1) {
+                    result.push_back({ stops_count / 2, stops_count - 1 });
+                }
+            }
+            return result;
+        }
+
+        // Расстояния от начала маршрута до каждой остановки
+        vector<int> GetPrefixDistances(const Bus& bus) {
+            vector<int> result(bus.stops.size(), 0);
+            for (size_t i = 1; i < bus.stops.size(); ++i) {
+                result[i] = result[i - 1] + bus.stops[i - 1]->GetDistance(bus.stops[i]);
+            }
+            return result;
+        }
+
+        // Номер клетки (x, y) на кривой Гильберта, заполняющей решетку side x side (side - степень двойки)
+        uint64_t GetHilbertIndex(uint32_t x, uint32_t y, uint32_t side) {
+            uint64_t index = 0;
+            for (uint32_t half = side / 2; half > 0; half /= 2) {
+                const uint32_t rx = (x & half) ? 1 : 0;
+                const uint32_t ry = (y & half) ? 1 : 0;
+                index += static_cast<uint64_t>(half) * half * ((3 * rx) ^ ry);
+                if (ry == 0) {
+                    if (rx == 1) {
+                        x = side - 1 - x;
+                        y = side - 1 - y;
+                    }
+                    swap(x, y);
+                }
+            }
+            return index;
+        }
+
+        // Остановки в порядке номеров их вершин
+        vector<const Stop*> GetOrderedStops(const map<string_view, Stop*>& all_stops, VertexOrder order) {
+            vector<const Stop*> result;
+            result.reserve(all_stops.size());
+            for (const auto& [stop_name, stop_ptr] : all_stops) {
+                result.push_back(stop_ptr);
+            }
+            if (order == VertexOrder::NAME || result.empty()) {
+                return result;
+            }
+
+            // Координаты в решетку 2^16 x 2^16 по охватывающему прямоугольнику, равные номера - по названиям
+            constexpr uint32_t GRID_SIDE = 1u << 16;
+            double min_lat = result.front()->coordinates.lat;
+            double max_lat = min_lat;
+            double min_lng = result.front()->coordinates.lng;
+            double max_lng = min_lng;
+            for (const Stop* stop : result) {
+                min_lat = min(min_lat, stop->coordinates.lat);
+                max_lat = max(max_lat, stop->coordinates.lat);
+                min_lng = min(min_lng, stop->coordinates.lng);
+                max_lng = max(max_lng, stop->coordinates.lng);
+            }
+            auto to_grid = [GRID_SIDE](double value, double min_value, double max_value) {
+                if (!(max_value > min_value)) {
+                    return 0u;
+                }
+                const double cell = (value - min_value) / (max_value - min_value) * (GRID_SIDE - 1);
+                return static_cast<uint32_t>(cell + 0.5);
+            };
+            vector<pair<uint64_t, const Stop*>> indexed_stops;
+            indexed_stops.reserve(result.size());
+            for (const Stop* stop : result) {
+                indexed_stops.push_back({ GetHilbertIndex(to_grid(stop->coordinates.lng, min_lng, max_lng),
+                    to_grid(stop->coordinates.lat, min_lat, max_lat), GRID_SIDE), stop });
+            }
+            stable_sort(indexed_stops.begin(), indexed_stops.end(),
+                [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+            for (size_t i = 0; i < indexed_stops.size(); ++i) {
+                result[i] = indexed_stops[i].second;
+            }
+            return result;
+        }
+
+        // Скорость в метрах в минуту по скорости в км/ч
+        double GetBusSpeed(double bus_velocity) {
+            return bus_velocity * (100.0 / 6.0);
+        }
+
+        // Поля ребра 32-битные, номера вершин и число пролетов приводятся явно
+        graph::Edge<double> MakeEdge(uint32_t name_id, size_t quality, graph::VertexId from, graph::VertexId to,
+            double weight) {
+            return { name_id, static_cast<uint32_t>(quality), static_cast<uint32_t>(from), static_cast<uint32_t>(to), weight };
+        }
+
+        // У каждой остановки пара вершин: четная (остановка) и следующая (ожидание посадки), пары всех
+        // остановок идут в начале графа. Ребро ожидания ведет из первой вершины пары во вторую
+        graph::Edge<double> MakeWaitEdge(uint32_t name_id, graph::VertexId stop_vertex, double bus_wait_time) {
+            return MakeEdge(name_id, 0, stop_vertex, stop_vertex + 1, bus_wait_time);
+        }
+
+        bool IsWaitEdge(const graph::Edge<double>& edge, size_t stop_count) {
+            return edge.from < stop_count * 2 && edge.from % 2 == 0 && edge.to == edge.from + 1;
+        }
+
+        // Автобус при построении графа: номер названия, рейсы, первая вершина остановок рейсов
+        // (модель BUS_LINES) и число ребер поездок
+        struct BusEdgesSource {
+            const Bus* bus = nullptr;
+            uint32_t name_id = 0;
+            vector<pair<size_t, size_t>> trips;
+            graph::VertexId line_vertex_begin = 0;
+            size_t edge_count = 0;
+        };
+
+        // Ребра поездок автобуса. Вершины остановок ищутся один раз на остановку маршрута
+        void AppendBusEdges(const BusEdgesSource& source, GraphModel graph_model,
+            const unordered_map<const Stop*, graph::VertexId>& stop_vertices, double bus_speed,
+            vector<graph::Edge<double>>& edges) {
+            const std::vector<Stop*>& stops = source.bus->stops;
+            const vector<int> distances = GetPrefixDistances(*source.bus);
+            vector<graph::VertexId> stop_vertex_ids(stops.size());
+            for (size_t i = 0; i < stops.size(); ++i) {
+                stop_vertex_ids[i] = stop_vertices.at(stops[i]);
+            }
+
+            graph::VertexId line_vertex_begin = source.line_vertex_begin;
+            for (const auto& [first, last] : source.trips) {
+                if (graph_model == GraphModel::BUS_LINES) {
+                    // Посадка с вершины ожидания, проезд до следующей остановки рейса, высадка на остановку
+                    for (size_t i = first; i <= last; ++i) {
+                        const graph::VertexId stop_vertex = stop_vertex_ids[i];
+                        const graph::VertexId line_vertex = line_vertex_begin + i - first;
+                        if (i < last) {
+                            edges.push_back(MakeEdge(source.name_id, 0, stop_vertex + 1, line_vertex, 0.0));
+                            edges.push_back(MakeEdge(source.name_id,
+                                                     1,
+                                                     line_vertex,
+                                                     line_vertex + 1,
+                                                     static_cast<double>(distances[i + 1] - distances[i]) / bus_speed));
+                        }
+                        if (i > first) {
+                            edges.push_back(MakeEdge(source.name_id, 0, line_vertex, stop_vertex, 0.0));
+                        }
+                    }
+                    line_vertex_begin += last - first + 1;
+                    continue;
+                }
+                // Ребро на каждую пару остановок рейса, расстояние - разность расстояний от начала маршрута
+                for (size_t i = first; i <= last; ++i) {
+                    const graph::VertexId vertex_from = stop_vertex_ids[i] + 1;
+                    for (size_t j = i + 1; j <= last; ++j) {
+                        edges.push_back(MakeEdge(source.name_id,
+                                                 j - i,
+                                                 vertex_from,
+                                                 stop_vertex_ids[j],
+                                                 static_cast<double>(distances[j] - distances[i]) / bus_speed));
+                    }
+                }
+            }
+        }
+
+        // Ребра поездок всех автобусов в конец edges. Автобусы делятся на непрерывные полосы примерно
+        // с равным числом ребер, каждый поток заполняет свой буфер, буферы дописываются по порядку полос.
+        // Поэтому номера ребер не зависят от числа потоков и совпадают с однопоточным построением
+        template <typename Edges>
+        void AppendAllBusEdges(const vector<BusEdgesSource>& sources, GraphModel graph_model,
+            const unordered_map<const Stop*, graph::VertexId>& stop_vertices, double bus_speed,
+            size_t thread_count, Edges& edges) {
+            constexpr size_t MIN_EDGES_PER_THREAD = size_t{ 1 } << 16;
+            size_t edge_count = 0;
+            for (const BusEdgesSource& source : sources) {
+                edge_count += source.edge_count;
+            }
+            if (thread_count == 0) {
+                thread_count = max<size_t>(thread::hardware_concurrency(), 1);
+            }
+            thread_count = max<size_t>(min({ thread_count, sources.size(), edge_count / MIN_EDGES_PER_THREAD }), 1);
+
+            // Границы полос: полоса thread_index начинается с автобуса, на котором сумма ребер
+            // предыдущих автобусов достигает edge_count * thread_index / thread_count
+            vector<size_t> bounds(thread_count + 1, sources.size());
+            bounds[0] = 0;
+            size_t prefix_edge_count = 0;
+            size_t thread_index = 1;
+            for (size_t i = 0; i < sources.size() && thread_index < thread_count; ++i) {
+                while (thread_index < thread_count && prefix_edge_count >= edge_count * thread_index / thread_count) {
+                    bounds[thread_index++] = i;
+                }
+                prefix_edge_count += sources[i].edge_count;
+            }
+
+            vector<vector<graph::Edge<double>>> buffers(thread_count);
+            auto build_range = [&](size_t index) {
+                vector<graph::Edge<double>>& buffer = buffers[index];
+                size_t range_edge_count = 0;
+                for (size_t i = bounds[index]; i < bounds[index + 1]; ++i) {
+                    range_edge_count += sources[i].edge_count;
+                }
+                buffer.reserve(range_edge_count);
+                for (size_t i = bounds[index]; i < bounds[index + 1]; ++i) {
+                    AppendBusEdges(sources[i], graph_model, stop_vertices, bus_speed, buffer);
+                }
+            };
+
+            vector<thread> threads;
+            threads.reserve(thread_count - 1);
+            for (size_t index = 1; index < thread_count; ++index) {
+                threads.emplace_back(build_range, index);
+            }
+            build_range(0);
+            for (auto& worker : threads) {
+                worker.join();
+            }
+
+            edges.reserve(edges.size() + edge_count);
+            for (const auto& buffer : buffers) {
+                edges.insert(edges.end(), buffer.begin(), buffer.end());
+            }
+        }
+
+        json::Node MakeWaitItem(const string& stop_name, double time) {
+            return json::Node(json::Dict{
+                {{"stop_name"s},{stop_name}},
+                {{"time"s},{time}},
+                {{"type"s},{"Wait"s}}
+                });
+        }
+
+        json::Node MakeBusItem(const string& bus_name, size_t span_count, double time) {
+            return json::Node(json::Dict{
+                {{"bus"s},{bus_name}},
+                {{"span_count"s},{static_cast<int>(span_count)}},
+                {{"time"s},{time}},
+                {{"type"s},{"Bus"s}}
+                });
+        }
+
+        // Роутер по файлу таблицы, если он задан, по сохраненной таблице, если она подходит к графу,
+        // иначе с расчетом таблицы заново
+        template <typename TableWeight>
+        unique_ptr<graph::Router<double, TableWeight>> MakeAllPairsRouter(
+            const graph::DirectedWeightedGraph<double>& graph, graph::RoutesTable<TableWeight>& routes_table,
+            const string& routes_table_file, size_t thread_count, storage::PageMode page_mode) {
+            const size_t vertex_count = graph.GetVertexCount();
+            unique_ptr<graph::Router<double, TableWeight>> result;
+            if (!routes_table_file.empty()) {
+                result = make_unique<graph::Router<double, TableWeight>>(graph, routes_table_file);
+            }
+            else if (routes_table.vertex_count == vertex_count
+                && routes_table.weights.size() == vertex_count * vertex_count) {
+                result = make_unique<graph::Router<double, TableWeight>>(graph, move(routes_table));
+            }
+            else {
+                result = make_unique<graph::Router<double, TableWeight>>(graph, thread_count, page_mode);
+            }
+            routes_table = {};
+            return result;
+        }
+
+    } // namespace
+
     Router::Router(const json::Node& settings_node) {
         if (settings_node.IsNull()) return;
         SetSettings(settings_node);
@@ -28,98 +407,316 @@ namespace transport {
         , stop_ids_(stop_ids) {
         if (settings_node.IsNull()) return;
         SetSettings(settings_node);
-        router_ptr_ = new graph::Router<double>(graph_);
+        BuildRouter();
     }
 
     void Router::SetGraph(graph::DirectedWeightedGraph<double>&& graph,
         std::map<std::string, graph::VertexId>&& stop_ids) {
         graph_ = move(graph);
         stop_ids_ = move(stop_ids);
-        router_ptr_ = new graph::Router<double>(graph_);
+        BuildRouter();
+    }
+
+    void Router::SetEdgeNames(std::vector<std::string>&& edge_names) {
+        edge_names_ = move(edge_names);
+    }
+
+    void Router::SetRoutesTable(graph::RoutesTable<double>&& routes_table) {
+        routes_table_ = move(routes_table);
+    }
+
+    void Router::SetRoutesTable(graph::RoutesTable<float>&& routes_table) {
+        float_routes_table_ = move(routes_table);
+    }
+
+    void Router::SetRoutesTable(graph::RoutesTable<graph::FixedTime>&& routes_table) {
+        fixed_routes_table_ = move(routes_table);
+    }
+
+    void Router::SetContractionHierarchy(graph::ContractionHierarchy<double>&& contraction_hierarchy) {
+        contraction_hierarchy_ = move(contraction_hierarchy);
+    }
+
+    void Router::SetHubLabels(graph::HubLabels<double>&& hub_labels) {
+        hub_labels_ = move(hub_labels);
+    }
+
+    void Router::SetCatalogue(const Catalogue& tcat) {
+        catalogue_ = &tcat;
+    }
+
+    void Router::SetBusWaitTime(int bus_wait_time) {
+        if (bus_wait_time < 0) {
+            throw logic_error("Negative bus wait time"s);
+        }
+        bus_wait_time_ = bus_wait_time;
+        if (raptor_router_ptr_) {
+            raptor_router_ptr_->SetBusWaitTime(bus_wait_time);
+        }
+
+        // Из вершины остановки выходит только ребро ожидания
+        vector<pair<graph::EdgeId, double>> new_weights;
+        new_weights.reserve(stop_ids_.size());
+        for (const auto& [stop_name, vertex_id] : stop_ids_) {
+            for (const graph::EdgeId edge_id : graph_.GetIncidentEdges(vertex_id)) {
+                if (IsWaitEdge(graph_.GetEdge(edge_id), stop_ids_.size())) {
+                    new_weights.push_back({ edge_id, static_cast<double>(bus_wait_time) });
+                }
+            }
+        }
+        UpdateEdgeWeights(new_weights);
+    }
+
+    void Router::SetBusVelocity(const std::string& bus_name, double bus_velocity) {
+        if (bus_velocity <= 0) {
+            throw logic_error("Bus velocity should be positive"s);
+        }
+        const Bus* bus = catalogue_ ? catalogue_->FindBus(bus_name) : nullptr;
+        if (catalogue_ && !bus) {
+            throw invalid_argument("Unknown bus: "s + bus_name);
+        }
+        if (raptor_router_ptr_) {
+            raptor_router_ptr_->SetBusVelocity(bus, bus_velocity);
+            return;
+        }
+        if (!bus) {
+            throw logic_error("Bus velocity update requires the catalogue"s);
+        }
+
+        // Номера названий автобусов идут после остановок в порядке названий
+        const auto bus_names_begin = edge_names_.begin() + stop_ids_.size();
+        const auto name_it = lower_bound(bus_names_begin, edge_names_.end(), bus_name);
+        if (name_it == edge_names_.end() || *name_it != bus_name) {
+            throw invalid_argument("Unknown bus: "s + bus_name);
+        }
+        const uint32_t bus_name_id = static_cast<uint32_t>(name_it - edge_names_.begin());
+
+        // Ребра автобуса идут подряд после ребер ожидания (по одному на остановку) по возрастанию
+        // номеров названий. Их веса считаются заново по расстояниям, как при построении графа,
+        // поэтому ошибки округления не накапливаются от обновления к обновлению
+        const auto& edges = graph_.GetEdges();
+        const auto edges_begin = lower_bound(edges.begin() + stop_ids_.size(), edges.end(), bus_name_id,
+            [](const graph::Edge<double>& edge, uint32_t name_id) { return edge.name_id < name_id; });
+        const auto edges_end = upper_bound(edges_begin, edges.end(), bus_name_id,
+            [](uint32_t name_id, const graph::Edge<double>& edge) { return name_id < edge.name_id; });
+
+        BusEdgesSource source;
+        source.bus = bus;
+        source.name_id = bus_name_id;
+        source.trips = GetBusTrips(*bus);
+        unordered_map<const Stop*, graph::VertexId> stop_vertices;
+        for (const Stop* stop : bus->stops) {
+            stop_vertices[stop] = stop_ids_.at(stop->name);
+        }
+        vector<graph::Edge<double>> bus_edges;
+        AppendBusEdges(source, graph_model_, stop_vertices, GetBusSpeed(bus_velocity), bus_edges);
+        if (bus_edges.size() != static_cast<size_t>(edges_end - edges_begin)) {
+            throw logic_error("Routing graph doesn't match the catalogue"s);
+        }
+
+        // Ребра посадки и высадки (модель BUS_LINES) весят 0 при любой скорости
+        vector<pair<graph::EdgeId, double>> new_weights;
+        const graph::EdgeId first_edge_id = static_cast<graph::EdgeId>(edges_begin - edges.begin());
+        for (size_t i = 0; i < bus_edges.size(); ++i) {
+            if (bus_edges[i].quality > 0) {
+                new_weights.push_back({ first_edge_id + i, bus_edges[i].weight });
+            }
+        }
+        UpdateEdgeWeights(new_weights);
+    }
+
+    void Router::ApplyUpdates(const json::Node& updates_node) {
+        if (updates_node.IsNull()) return;
+        for (const auto& update_node : updates_node.AsArray()) {
+            const json::Dict& update = update_node.AsDict();
+            const string& type = update.at("type"s).AsString();
+            if (type == "Wait"s) {
+                SetBusWaitTime(update.at("bus_wait_time"s).AsInt());
+            }
+            else if (type == "Bus"s) {
+                SetBusVelocity(update.at("name"s).AsString(), update.at("bus_velocity"s).AsDouble());
+            }
+            else {
+                throw logic_error("Unknown routing update type: "s + type);
+            }
+        }
+    }
+
+    RoutingUpdateStats Router::GetUpdateStats() const {
+        return update_stats_;
+    }
+
+    void Router::UpdateEdgeWeights(const std::vector<std::pair<graph::EdgeId, double>>& new_weights) {
+        vector<pair<graph::EdgeId, double>> old_weights;
+        old_weights.reserve(new_weights.size());
+        for (const auto& [edge_id, weight] : new_weights) {
+            old_weights.push_back({ edge_id, graph_.GetEdge(edge_id).weight });
+            graph_.SetEdgeWeight(edge_id, weight);
+        }
+        update_stats_.updated_edges += new_weights.size();
+        if (route_cache_) {
+            route_cache_->Clear();
+        }
+
+        // Строки таблиц пересчитываются поиском Дейкстры по графу с новыми весами
+        const graph::DijkstraRouter<double> dijkstra_router(graph_);
+        auto build_row = [&dijkstra_router](graph::VertexId from,
+            vector<double>& weights, vector<uint32_t>& prev_edges) {
+            dijkstra_router.BuildRoutesRow(from, weights, prev_edges);
+        };
+        switch (routing_engine_) {
+        case RoutingEngine::A_STAR:
+            // Оценка по расстоянию по прямой зависит от весов ребер
+            dijkstra_router_ptr_ = make_unique<graph::DijkstraRouter<double>>(graph_, MakeGeoLowerBound());
+            break;
+        case RoutingEngine::CONTRACTION_HIERARCHIES:
+            // Shortcut-ребра выбраны по старым весам, поэтому иерархия строится заново
+            ch_router_ptr_ = make_unique<graph::ContractionHierarchyRouter<double>>(graph_);
+            break;
+        case RoutingEngine::HUB_LABELS:
+            // Покрытие путей хабами зависит от весов, метки строятся заново. Порядок хабов влияет
+            // только на размер меток, поэтому остается прежним, без новой иерархии сокращений
+            hub_label_router_ptr_->UpdateLabels();
+            break;
+        case RoutingEngine::LAZY_TABLE:
+            update_stats_.repaired_rows += lazy_router_ptr_->RepairRoutes(old_weights);
+            break;
+        case RoutingEngine::ALL_PAIRS:
+            if (float_router_ptr_) {
+                update_stats_.repaired_rows += float_router_ptr_->RepairRoutes(old_weights, build_row);
+            }
+            else if (fixed_router_ptr_) {
+                update_stats_.repaired_rows += fixed_router_ptr_->RepairRoutes(old_weights, build_row);
+            }
+            else {
+                update_stats_.repaired_rows += router_ptr_->RepairRoutes(old_weights, build_row);
+            }
+            break;
+        default:
+            break;
+        }
     }
 
     const graph::DirectedWeightedGraph<double>& Router::BuildGraph(const Catalogue& tcat) {
+        catalogue_ = &tcat;
 
         // Получаем отсортированный список всех остановок и автобусов
         const map<string_view, Stop*>& all_stops = tcat.GetSortedAllStops();
         const map<string_view, Bus*>& all_buses = tcat.GetSortedAllBuses();
 
-        // Создаем граф остановок и дорог с учетом размера списка остановок
-        graph::DirectedWeightedGraph<double> stops_graph(all_stops.size() * 2);
+        // Ребра графа в порядке номеров, сразу в памяти со страницами page_mode_
+        graph::DirectedWeightedGraph<double>::Edges edges{ storage::PageAllocator<graph::Edge<double>>(page_mode_) };
 
-        // Создаем map идентификаторов для остановок
+        // Создаем map идентификаторов для остановок и вершины остановок по указателю - для ребер поездок
         map<std::string, graph::VertexId> stop_ids;
+        unordered_map<const Stop*, graph::VertexId> stop_vertices;
+        stop_vertices.reserve(all_stops.size());
 
         // Инициализируем идентификатор вершины
         graph::VertexId vertex_id = 0;
+        vector<string> edge_names;
+        edge_names.reserve(all_stops.size() + all_buses.size());
 
         // Добавляем ребра для каждой остановки на временную остановку
         // и обратное ребро для каждой временной остановки на прямую остановку
-        for (const auto& [stop_name, stop_ptr] : all_stops) {
+        for (const Stop* stop_ptr : GetOrderedStops(all_stops, vertex_order_)) {
             stop_ids[stop_ptr->name] = vertex_id;
-            stops_graph.AddEdge({ stop_ptr->name,
-                                  0,
-                                  vertex_id,
-                                  ++vertex_id,
-                                  static_cast<double>(bus_wait_time_) });
-            ++vertex_id;
+            stop_vertices[stop_ptr] = vertex_id;
+            edges.push_back(MakeWaitEdge(static_cast<uint32_t>(edge_names.size()), vertex_id,
+                                         static_cast<double>(bus_wait_time_)));
+            vertex_id += 2;
+            edge_names.push_back(stop_ptr->name);
         }
         stop_ids_ = move(stop_ids);
+        for (const auto& [bus_name, bus_ptr] : all_buses) {
+            edge_names.push_back(bus_ptr->name);
+        }
+        edge_names_ = move(edge_names);
 
-        // Добавляем ребра между остановками для каждого автобуса
-      // Расстояния между остановками и время в пути вычисляются с помощью методов класса TransportCatalogu
-        for_each(
-            all_buses.begin(),
-            all_buses.end(),
-            [&stops_graph, this](const auto& item)
-            {
-                const auto& bus_ptr = item.second;
-                const std::vector<Stop*>& stops = bus_ptr->stops;
-                size_t stops_count = stops.size();
-                for (size_t i = 0; i < stops_count; ++i) {
-                    for (size_t j = i + 1; j < stops_count; ++j) {
-                        const Stop* stop_from = stops[i];
-                        const Stop* stop_to = stops[j];
-                        int dist_sum = 0;
-                        // Вычисляем суммарное расстояние между остановками и обратное расстояние
-                        for (size_t k = i + 1; k <= j; ++k) {
-                            dist_sum += stops[k - 1]->GetDistance(stops[k]);
-                        }
-                        // Добавляем ребро между остановками и устанавливаем время в пути
-                        stops_graph.AddEdge({ bus_ptr->name,
-                                              j - i,
-                                              stop_ids_.at(stop_from->name) + 1,
-                                              stop_ids_.at(stop_to->name),
-                                              static_cast<double>(dist_sum) / (bus_velocity_ * (100.0 / 6.0)) });
-                        if (!bus_ptr->is_circle && stop_to == bus_ptr->final_stop && j == stops_count / 2) break;
-                    }
+        // RAPTOR ищет по спискам остановок автобусов, ребра поездок ему не нужны
+        if (routing_engine_ == RoutingEngine::RAPTOR) {
+            graph_ = graph::DirectedWeightedGraph<double>(vertex_id, move(edges));
+            BuildRouter();
+            return graph_;
+        }
+
+        // Автобусы в порядке названий: номер названия - после названий всех остановок,
+        // для модели BUS_LINES - вершины остановок рейсов (по вершине на каждую остановку каждого рейса)
+        vector<BusEdgesSource> sources;
+        sources.reserve(all_buses.size());
+        uint32_t bus_name_id = static_cast<uint32_t>(all_stops.size());
+        for (const auto& [bus_name, bus_ptr] : all_buses) {
+            BusEdgesSource& source = sources.emplace_back();
+            source.bus = bus_ptr;
+            source.name_id = bus_name_id++;
+            source.trips = GetBusTrips(*bus_ptr);
+            source.line_vertex_begin = vertex_id;
+            for (const auto& [first, last] : source.trips) {
+                const size_t trip_stops_count = last - first + 1;
+                if (graph_model_ == GraphModel::BUS_LINES) {
+                    source.edge_count += 3 * (trip_stops_count - 1);
+                    vertex_id += trip_stops_count;
                 }
-            });
+                else {
+                    source.edge_count += trip_stops_count * (trip_stops_count - 1) / 2;
+                }
+            }
+        }
 
-        graph_ = move(stops_graph);
-        router_ptr_ = new graph::Router<double>(graph_);
+        const double bus_speed = GetBusSpeed(bus_velocity_);
+        AppendAllBusEdges(sources, graph_model_, stop_vertices, bus_speed, routing_threads_, edges);
+
+        graph_ = graph::DirectedWeightedGraph<double>(vertex_id, move(edges));
+        if (routing_engine_ == RoutingEngine::ALL_PAIRS && !routes_table_file_.empty()) {
+            WriteRoutesTableFile();
+        }
+        BuildRouter();
         return graph_;
     }
 
+    void Router::WriteRoutesTableFile() const {
+        // Строки считаются поиском Дейкстры и сразу пишутся в файл, таблица целиком в памяти не нужна
+        const graph::DijkstraRouter<double> dijkstra_router(graph_);
+        auto build_row = [&dijkstra_router](graph::VertexId from,
+            vector<double>& weights, vector<uint32_t>& prev_edges) {
+            dijkstra_router.BuildRoutesRow(from, weights, prev_edges);
+        };
+        switch (routes_table_precision_) {
+        case RoutesTablePrecision::FLOAT:
+            graph::Router<double, float>::WriteRoutesTableFile(graph_, routes_table_file_, build_row, routing_threads_);
+            break;
+        case RoutesTablePrecision::FIXED:
+            graph::Router<double, graph::FixedTime>::WriteRoutesTableFile(graph_, routes_table_file_, build_row,
+                routing_threads_);
+            break;
+        default:
+            graph::Router<double>::WriteRoutesTableFile(graph_, routes_table_file_, build_row, routing_threads_);
+        }
+    }
+
     json::Array Router::GetEdgesItems(const std::vector<graph::EdgeId>& edges) const {
+        // Ребра модели BUS_LINES (посадка, проезды до высадки) собираются в один элемент Bus
+        const graph::VertexId line_vertex_begin = stop_ids_.size() * 2;
         json::Array items_array;
         items_array.reserve(edges.size());
+        size_t span_count = 0;
+        double ride_time = 0;
         for (auto& edge_id : edges) {
             const graph::Edge<double>& edge = graph_.GetEdge(edge_id);
-            if (edge.quality == 0) {
-                items_array.emplace_back(json::Node(json::Dict{
-                    {{"stop_name"s},{static_cast<string>(edge.name)}},
-                    {{"time"s},{edge.weight}},
-                    {{"type"s},{"Wait"s}}
-                    }));
+            if (edge.from >= line_vertex_begin || edge.to >= line_vertex_begin) {
+                span_count += edge.quality;
+                ride_time += edge.weight;
+                if (edge.to < line_vertex_begin) {
+                    items_array.emplace_back(MakeBusItem(edge_names_[edge.name_id], span_count, ride_time));
+                    span_count = 0;
+                    ride_time = 0;
+                }
+            }
+            else if (edge.quality == 0) {
+                items_array.emplace_back(MakeWaitItem(edge_names_[edge.name_id], edge.weight));
             }
             else {
-                items_array.emplace_back(json::Node(json::Dict{
-                    {{"bus"s},{static_cast<string>(edge.name)}},
-                    {{"span_count"s},{static_cast<int>(edge.quality)}},
-                    {{"time"s},{edge.weight}},
-                    {{"type"s},{"Bus"s}}
-                    }));
+                items_array.emplace_back(MakeBusItem(edge_names_[edge.name_id], edge.quality, edge.weight));
             }
         }
 
@@ -127,7 +724,299 @@ namespace transport {
     }
 
     std::optional<graph::Router<double>::RouteInfo> Router::GetRouteInfo(const Stop* from, const Stop* to) const {
-        return router_ptr_->BuildRoute(stop_ids_.at(from->name), stop_ids_.at(to->name));
+        if (routing_engine_ == RoutingEngine::RAPTOR) {
+            throw logic_error("RAPTOR routes have no graph edges, use GetRouteItems"s);
+        }
+        const graph::VertexId vertex_from = stop_ids_.at(from->name);
+        const graph::VertexId vertex_to = stop_ids_.at(to->name);
+        if (!route_cache_) {
+            return BuildRouteInfo(vertex_from, vertex_to);
+        }
+
+        const uint64_t key = GetRouteCacheKey(vertex_from, vertex_to);
+        if (auto cached_route = route_cache_->Get(key)) {
+            if (!(*cached_route)->is_found) {
+                return nullopt;
+            }
+            return (*cached_route)->route_info;
+        }
+        auto route_info = BuildRouteInfo(vertex_from, vertex_to);
+        auto cached_route = make_shared<CachedRoute>();
+        if (route_info) {
+            cached_route->is_found = true;
+            cached_route->route_info = *route_info;
+        }
+        route_cache_->Put(key, move(cached_route));
+        return route_info;
+    }
+
+    std::optional<RouteItems> Router::GetRouteItems(const Stop* from, const Stop* to) const {
+        // У RAPTOR нет ребер графа, поэтому в кэше могут быть только готовые элементы
+        const bool cache_items = route_cache_ && (cache_route_items_ || routing_engine_ == RoutingEngine::RAPTOR);
+        if (!cache_items) {
+            return BuildRouteItems(from, to);
+        }
+
+        const uint64_t key = GetRouteCacheKey(stop_ids_.at(from->name), stop_ids_.at(to->name));
+        if (auto cached_route = route_cache_->Get(key)) {
+            if (!(*cached_route)->is_found) {
+                return nullopt;
+            }
+            const CachedRoute& route = **cached_route;
+            if (route.items) {
+                return RouteItems{ route.route_info.weight, *route.items };
+            }
+            // Маршрут сохранен запросом без элементов (GetRouteInfo): элементы строятся по его ребрам
+            // без нового поиска и добавляются в кэш
+            auto completed_route = make_shared<CachedRoute>(route);
+            completed_route->items = GetEdgesItems(route.route_info.edges);
+            RouteItems result{ route.route_info.weight, *completed_route->items };
+            route_cache_->Put(key, move(completed_route));
+            return result;
+        }
+        auto cached_route = make_shared<CachedRoute>();
+        std::optional<RouteItems> result;
+        if (routing_engine_ == RoutingEngine::RAPTOR) {
+            result = BuildRouteItems(from, to);
+            if (result) {
+                cached_route->route_info.weight = result->total_time;
+            }
+        }
+        else if (auto route_info = BuildRouteInfo(stop_ids_.at(from->name), stop_ids_.at(to->name))) {
+            result = RouteItems{ route_info->weight, GetEdgesItems(route_info->edges) };
+            cached_route->route_info = move(*route_info);
+        }
+        if (result) {
+            cached_route->is_found = true;
+            cached_route->items = result->items;
+        }
+        route_cache_->Put(key, move(cached_route));
+        return result;
+    }
+
+    std::optional<RouteItems> Router::GetViaRouteItems(const std::vector<const Stop*>& stops) const {
+        if (stops.empty()) {
+            return nullopt;
+        }
+        RouteItems result;
+        for (size_t i = 1; i < stops.size(); ++i) {
+            // Участок из остановки в нее же - пустой маршрут без поиска
+            if (stops[i - 1] == stops[i]) {
+                continue;
+            }
+            auto leg = GetRouteItems(stops[i - 1], stops[i]);
+            if (!leg) {
+                return nullopt;
+            }
+            result.total_time += leg->total_time;
+            if (result.items.empty()) {
+                result.items = move(leg->items);
+                continue;
+            }
+            result.items.insert(result.items.end(), make_move_iterator(leg->items.begin()),
+                make_move_iterator(leg->items.end()));
+        }
+        return result;
+    }
+
+    std::vector<std::vector<std::optional<double>>> Router::GetRouteMatrix(const std::vector<const Stop*>& from,
+        const std::vector<const Stop*>& to) const {
+        std::vector<std::vector<std::optional<double>>> result;
+        result.reserve(from.size());
+
+        if (routing_engine_ == RoutingEngine::RAPTOR) {
+            for (const Stop* stop_from : from) {
+                result.push_back(raptor_router_ptr_->GetTravelTimes(stop_from, to));
+            }
+            return result;
+        }
+
+        vector<graph::VertexId> vertices_to;
+        vertices_to.reserve(to.size());
+        for (const Stop* stop_to : to) {
+            vertices_to.push_back(stop_ids_.at(stop_to->name));
+        }
+
+        if (routing_engine_ == RoutingEngine::ALL_PAIRS || routing_engine_ == RoutingEngine::LAZY_TABLE) {
+            for (const Stop* stop_from : from) {
+                const graph::VertexId vertex_from = stop_ids_.at(stop_from->name);
+                auto& row = result.emplace_back();
+                row.reserve(vertices_to.size());
+                for (const graph::VertexId vertex_to : vertices_to) {
+                    if (lazy_router_ptr_) {
+                        row.push_back(lazy_router_ptr_->GetRouteWeight(vertex_from, vertex_to));
+                    }
+                    else if (float_router_ptr_) {
+                        row.push_back(float_router_ptr_->GetRouteWeight(vertex_from, vertex_to));
+                    }
+                    else if (fixed_router_ptr_) {
+                        row.push_back(fixed_router_ptr_->GetRouteWeight(vertex_from, vertex_to));
+                    }
+                    else {
+                        row.push_back(router_ptr_->GetRouteWeight(vertex_from, vertex_to));
+                    }
+                }
+            }
+            return result;
+        }
+
+        if (routing_engine_ == RoutingEngine::HUB_LABELS) {
+            for (const Stop* stop_from : from) {
+                const graph::VertexId vertex_from = stop_ids_.at(stop_from->name);
+                auto& row = result.emplace_back();
+                row.reserve(vertices_to.size());
+                for (const graph::VertexId vertex_to : vertices_to) {
+                    row.push_back(hub_label_router_ptr_->GetRouteWeight(vertex_from, vertex_to));
+                }
+            }
+            return result;
+        }
+
+        // Иерархия сокращений и двунаправленный поиск отвечают на запросы пар вершин, поэтому поиск
+        // из каждой вершины отправления идет по исходному графу поиском для запросов без одной цели
+        const graph::DijkstraRouter<double>& dijkstra_router = dijkstra_router_ptr_
+            ? *dijkstra_router_ptr_ : *bounded_search_router_ptr_;
+        for (const Stop* stop_from : from) {
+            result.push_back(dijkstra_router.GetRouteWeights(stop_ids_.at(stop_from->name), vertices_to));
+        }
+        return result;
+    }
+
+    std::vector<ParetoRouteItems> Router::GetParetoRoutes(const Stop* from, const Stop* to,
+        size_t max_transfers) const {
+        vector<ParetoRouteItems> result;
+        if (raptor_router_ptr_) {
+            for (const RaptorRouter::Route& route : raptor_router_ptr_->BuildParetoRoutes(from, to)) {
+                if (route.legs.size() > max_transfers + 1) {
+                    break;
+                }
+                ParetoRouteItems& route_items = result.emplace_back();
+                route_items.transfer_count = route.legs.empty() ? 0 : route.legs.size() - 1;
+                route_items.route.total_time = route.total_time;
+                for (const RaptorRouter::Leg& leg : route.legs) {
+                    route_items.route.items.emplace_back(MakeWaitItem(leg.board_stop->name,
+                        static_cast<double>(bus_wait_time_)));
+                    route_items.route.items.emplace_back(MakeBusItem(leg.bus->name, leg.span_count, leg.ride_time));
+                }
+            }
+            return result;
+        }
+
+        const uint32_t max_count = static_cast<uint32_t>(min<size_t>(max_transfers + 1, numeric_limits<uint32_t>::max()));
+        for (const auto& [count, route_info] : GetParetoRouter().BuildRoutes(stop_ids_.at(from->name),
+            stop_ids_.at(to->name), max_count)) {
+            result.push_back({ count == 0 ? 0 : count - 1u, { route_info.weight, GetEdgesItems(route_info.edges) } });
+        }
+        return result;
+    }
+
+    std::vector<ReachableStop> Router::GetReachableStops(const Stop* from, double max_time) const {
+        vector<ReachableStop> result;
+        if (raptor_router_ptr_) {
+            for (const auto& [stop, time] : raptor_router_ptr_->GetReachableStops(from, max_time)) {
+                result.push_back({ stop->name, time });
+            }
+        }
+        else {
+            // Оценка A* для поиска без цели не нужна, раскрытие по весу и так дает ответ
+            const graph::DijkstraRouter<double>& dijkstra_router = dijkstra_router_ptr_
+                ? *dijkstra_router_ptr_ : *bounded_search_router_ptr_;
+            const graph::VertexId stop_vertex_end = stop_ids_.size() * 2;
+            for (const auto& [vertex, time] : dijkstra_router.GetReachableVertices(stop_ids_.at(from->name), max_time)) {
+                // Вершины остановок четные, название остановки - по номеру вершины
+                if (vertex < stop_vertex_end && vertex % 2 == 0) {
+                    result.push_back({ edge_names_[vertex / 2], time });
+                }
+            }
+        }
+        sort(result.begin(), result.end(), [](const ReachableStop& lhs, const ReachableStop& rhs) {
+            return make_pair(lhs.time, lhs.stop_name) < make_pair(rhs.time, rhs.stop_name);
+            });
+        return result;
+    }
+
+    graph::SearchStats Router::GetSearchStats() const {
+        if (bidirectional_router_ptr_) {
+            return bidirectional_router_ptr_->GetSearchStats();
+        }
+        if (lazy_router_ptr_) {
+            return lazy_router_ptr_->GetSearchStats();
+        }
+        return dijkstra_router_ptr_ ? dijkstra_router_ptr_->GetSearchStats() : graph::SearchStats{};
+    }
+
+    graph::SearchStats Router::GetParetoSearchStats() const {
+        if (!pareto_search_) {
+            return {};
+        }
+        lock_guard lock(pareto_search_->mutex);
+        return pareto_search_->router ? pareto_search_->router->GetSearchStats() : graph::SearchStats{};
+    }
+
+    const graph::ParetoRouter<double>& Router::GetParetoRouter() const {
+        lock_guard lock(pareto_search_->mutex);
+        if (!pareto_search_->router) {
+            const size_t stop_count = stop_ids_.size();
+            pareto_search_->router = make_unique<graph::ParetoRouter<double>>(graph_,
+                [stop_count](const graph::Edge<double>& edge) { return IsWaitEdge(edge, stop_count); });
+        }
+        return *pareto_search_->router;
+    }
+
+    cache::CacheStats Router::GetRouteCacheStats() const {
+        return route_cache_ ? route_cache_->GetStats() : cache::CacheStats{};
+    }
+
+    uint64_t Router::GetRouteCacheKey(graph::VertexId from, graph::VertexId to) {
+        return (static_cast<uint64_t>(from) << 32) | static_cast<uint64_t>(to);
+    }
+
+    std::optional<graph::Router<double>::RouteInfo> Router::BuildRouteInfo(graph::VertexId from,
+        graph::VertexId to) const {
+        switch (routing_engine_) {
+        case RoutingEngine::DIJKSTRA:
+        case RoutingEngine::A_STAR:
+            return dijkstra_router_ptr_->BuildRoute(from, to);
+        case RoutingEngine::BIDIRECTIONAL_DIJKSTRA:
+            return bidirectional_router_ptr_->BuildRoute(from, to);
+        case RoutingEngine::LAZY_TABLE:
+            return lazy_router_ptr_->BuildRoute(from, to);
+        case RoutingEngine::CONTRACTION_HIERARCHIES:
+            return ch_router_ptr_->BuildRoute(from, to);
+        case RoutingEngine::HUB_LABELS:
+            return hub_label_router_ptr_->BuildRoute(from, to);
+        case RoutingEngine::RAPTOR:
+            throw logic_error("RAPTOR routes have no graph edges, use GetRouteItems"s);
+        default:
+            if (float_router_ptr_) {
+                return float_router_ptr_->BuildRoute(from, to);
+            }
+            if (fixed_router_ptr_) {
+                return fixed_router_ptr_->BuildRoute(from, to);
+            }
+            return router_ptr_->BuildRoute(from, to);
+        }
+    }
+
+    std::optional<RouteItems> Router::BuildRouteItems(const Stop* from, const Stop* to) const {
+        if (routing_engine_ != RoutingEngine::RAPTOR) {
+            if (auto route_info = GetRouteInfo(from, to)) {
+                return RouteItems{ route_info->weight, GetEdgesItems(route_info->edges) };
+            }
+            return nullopt;
+        }
+
+        auto route = raptor_router_ptr_->BuildRoute(from, to);
+        if (!route) {
+            return nullopt;
+        }
+        RouteItems result{ route->total_time, {} };
+        result.items.reserve(route->legs.size() * 2);
+        for (const RaptorRouter::Leg& leg : route->legs) {
+            result.items.emplace_back(MakeWaitItem(leg.board_stop->name, static_cast<double>(bus_wait_time_)));
+            result.items.emplace_back(MakeBusItem(leg.bus->name, leg.span_count, leg.ride_time));
+        }
+        return result;
     }
 
     size_t Router::GetGraphVertexCount() {
@@ -142,16 +1031,238 @@ namespace transport {
         return graph_;
     }
 
+    const std::vector<std::string>& Router::GetEdgeNames() const {
+        return edge_names_;
+    }
+
+    const graph::RoutesTable<double>* Router::GetRoutesTable() const {
+        return router_ptr_ && routes_table_file_.empty() ? &router_ptr_->GetRoutesTable() : nullptr;
+    }
+
+    const graph::RoutesTable<float>* Router::GetFloatRoutesTable() const {
+        return float_router_ptr_ && routes_table_file_.empty() ? &float_router_ptr_->GetRoutesTable() : nullptr;
+    }
+
+    const graph::RoutesTable<graph::FixedTime>* Router::GetFixedRoutesTable() const {
+        return fixed_router_ptr_ && routes_table_file_.empty() ? &fixed_router_ptr_->GetRoutesTable() : nullptr;
+    }
+
+    const graph::ContractionHierarchy<double>* Router::GetContractionHierarchy() const {
+        return ch_router_ptr_ ? &ch_router_ptr_->GetHierarchy() : nullptr;
+    }
+
+    const graph::HubLabels<double>* Router::GetHubLabels() const {
+        return hub_label_router_ptr_ ? &hub_label_router_ptr_->GetLabels() : nullptr;
+    }
+
+    storage::PageMode Router::GetPageMode() const {
+        return page_mode_;
+    }
+
     json::Node Router::GetSettings() const {
         return json::Node(json::Dict{
             {{"bus_wait_time"s},{bus_wait_time_}},
-            {{"bus_velocity"s},{bus_velocity_}}
+            {{"bus_velocity"s},{bus_velocity_}},
+            {{"routing_engine"s},{GetRoutingEngineName(routing_engine_)}},
+            {{"routes_table_precision"s},{GetRoutesTablePrecisionName(routes_table_precision_)}},
+            {{"routing_threads"s},{static_cast<int>(routing_threads_)}},
+            {{"graph_model"s},{GetGraphModelName(graph_model_)}},
+            {{"vertex_order"s},{GetVertexOrderName(vertex_order_)}},
+            {{"huge_pages"s},{GetPageModeName(page_mode_)}},
+            {{"route_cache_size"s},{static_cast<int>(route_cache_size_)}},
+            {{"route_cache_items"s},{cache_route_items_}},
+            {{"routes_table_file"s},{routes_table_file_}}
             });
     }
 
     void Router::SetSettings(const json::Node& settings_node) {
         bus_wait_time_ = settings_node.AsDict().at("bus_wait_time"s).AsInt();
         bus_velocity_ = settings_node.AsDict().at("bus_velocity"s).AsDouble();
+        if (settings_node.AsDict().count("routing_engine"s)) {
+            routing_engine_ = ParseRoutingEngine(settings_node.AsDict().at("routing_engine"s).AsString());
+        }
+        if (settings_node.AsDict().count("routes_table_precision"s)) {
+            routes_table_precision_ = ParseRoutesTablePrecision(
+                settings_node.AsDict().at("routes_table_precision"s).AsString());
+        }
+        if (settings_node.AsDict().count("routing_threads"s)) {
+            const int routing_threads = settings_node.AsDict().at("routing_threads"s).AsInt();
+            if (routing_threads < 0) {
+                throw logic_error("Negative routing threads count"s);
+            }
+            routing_threads_ = static_cast<size_t>(routing_threads);
+        }
+        if (settings_node.AsDict().count("graph_model"s)) {
+            graph_model_ = ParseGraphModel(settings_node.AsDict().at("graph_model"s).AsString());
+        }
+        if (settings_node.AsDict().count("vertex_order"s)) {
+            vertex_order_ = ParseVertexOrder(settings_node.AsDict().at("vertex_order"s).AsString());
+        }
+        if (settings_node.AsDict().count("huge_pages"s)) {
+            page_mode_ = ParsePageMode(settings_node.AsDict().at("huge_pages"s).AsString());
+        }
+        if (settings_node.AsDict().count("route_cache_size"s)) {
+            const int route_cache_size = settings_node.AsDict().at("route_cache_size"s).AsInt();
+            if (route_cache_size < 0) {
+                throw logic_error("Negative route cache size"s);
+            }
+            route_cache_size_ = static_cast<size_t>(route_cache_size);
+        }
+        if (settings_node.AsDict().count("route_cache_items"s)) {
+            cache_route_items_ = settings_node.AsDict().at("route_cache_items"s).AsBool();
+        }
+        if (settings_node.AsDict().count("routes_table_file"s)) {
+            routes_table_file_ = settings_node.AsDict().at("routes_table_file"s).AsString();
+        }
+    }
+
+    graph::DijkstraRouter<double>::LowerBound Router::MakeGeoLowerBound() const {
+        // Координаты вершин: у обеих вершин остановки - координаты остановки, у вершин остановок
+        // рейсов (модель BUS_LINES) - координаты остановки на другом конце ребра посадки или высадки
+        const size_t vertex_count = graph_.GetVertexCount();
+        vector<geo::Coordinates> coordinates(vertex_count);
+        vector<char> is_located(vertex_count, false);
+        for (const auto& [stop_name, vertex_id] : stop_ids_) {
+            const Stop* stop = catalogue_->FindStop(stop_name);
+            if (!stop) {
+                continue;
+            }
+            coordinates[vertex_id] = coordinates[vertex_id + 1] = stop->coordinates;
+            is_located[vertex_id] = is_located[vertex_id + 1] = true;
+        }
+        for (graph::EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+            const graph::Edge<double>& edge = graph_.GetEdge(edge_id);
+            if (edge.quality != 0 || is_located[edge.from] == is_located[edge.to]) {
+                continue;
+            }
+            const graph::VertexId located = is_located[edge.from] ? edge.from : edge.to;
+            const graph::VertexId unlocated = is_located[edge.from] ? edge.to : edge.from;
+            coordinates[unlocated] = coordinates[located];
+            is_located[unlocated] = true;
+        }
+
+        // Время на метр расстояния по прямой: минимум по всем ребрам графа, а не 1 / bus_velocity,
+        // так как расстояние по дорогам в базе может быть и меньше расстояния по прямой.
+        // Тогда оценка по неравенству треугольника не больше веса любого пути до цели
+        double time_per_meter = numeric_limits<double>::infinity();
+        for (graph::EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+            const graph::Edge<double>& edge = graph_.GetEdge(edge_id);
+            if (!is_located[edge.from] || !is_located[edge.to]) {
+                continue;
+            }
+            const double distance = geo::ComputeDistance(coordinates[edge.from], coordinates[edge.to]);
+            if (distance > GEO_DISTANCE_TOLERANCE) {
+                time_per_meter = min(time_per_meter, edge.weight / distance);
+            }
+        }
+        if (time_per_meter == numeric_limits<double>::infinity()) {
+            time_per_meter = 0;
+        }
+
+        // Из вершины остановки (четной) выходит только ребро ожидания, поэтому путь из нее
+        // в другую вершину не короче bus_wait_time
+        const graph::VertexId stop_vertex_end = stop_ids_.size() * 2;
+        const double bus_wait_time = static_cast<double>(bus_wait_time_);
+        return [coordinates = move(coordinates), is_located = move(is_located), time_per_meter,
+            stop_vertex_end, bus_wait_time](graph::VertexId vertex, graph::VertexId target) {
+            const double wait_time = vertex != target && vertex < stop_vertex_end && vertex % 2 == 0
+                ? bus_wait_time : 0.0;
+            if (!is_located[vertex] || !is_located[target]) {
+                return wait_time;
+            }
+            const double distance = geo::ComputeDistance(coordinates[vertex], coordinates[target]);
+            return wait_time + time_per_meter * max(distance - GEO_DISTANCE_TOLERANCE, 0.0);
+        };
+    }
+
+    void Router::BuildRouter() {
+        router_ptr_.reset();
+        float_router_ptr_.reset();
+        fixed_router_ptr_.reset();
+        dijkstra_router_ptr_.reset();
+        bidirectional_router_ptr_.reset();
+        lazy_router_ptr_.reset();
+        ch_router_ptr_.reset();
+        raptor_router_ptr_.reset();
+        hub_label_router_ptr_.reset();
+        bounded_search_router_ptr_.reset();
+        pareto_search_.reset();
+        route_cache_.reset();
+        graph_.SetPageMode(page_mode_);
+        if (route_cache_size_ > 0) {
+            route_cache_ = make_unique<RouteCache>(route_cache_size_);
+        }
+        switch (routing_engine_) {
+        case RoutingEngine::DIJKSTRA:
+            dijkstra_router_ptr_ = make_unique<graph::DijkstraRouter<double>>(graph_);
+            break;
+        case RoutingEngine::A_STAR:
+            if (!catalogue_) {
+                throw logic_error("A* routing engine requires the catalogue"s);
+            }
+            dijkstra_router_ptr_ = make_unique<graph::DijkstraRouter<double>>(graph_, MakeGeoLowerBound());
+            break;
+        case RoutingEngine::BIDIRECTIONAL_DIJKSTRA:
+            bidirectional_router_ptr_ = make_unique<graph::BidirectionalDijkstraRouter<double>>(graph_);
+            break;
+        case RoutingEngine::LAZY_TABLE:
+            lazy_router_ptr_ = make_unique<graph::LazyRouter<double>>(graph_);
+            break;
+        case RoutingEngine::CONTRACTION_HIERARCHIES:
+            if (contraction_hierarchy_.ranks.size() == graph_.GetVertexCount()) {
+                ch_router_ptr_ = make_unique<graph::ContractionHierarchyRouter<double>>(graph_,
+                    move(contraction_hierarchy_));
+            }
+            else {
+                ch_router_ptr_ = make_unique<graph::ContractionHierarchyRouter<double>>(graph_);
+            }
+            break;
+        case RoutingEngine::HUB_LABELS:
+            if (hub_labels_.hubs.size() == graph_.GetVertexCount()) {
+                hub_label_router_ptr_ = make_unique<graph::HubLabelRouter<double>>(graph_, move(hub_labels_));
+            }
+            else {
+                hub_label_router_ptr_ = MakeHubLabelRouter();
+            }
+            break;
+        case RoutingEngine::RAPTOR:
+            if (!catalogue_) {
+                throw logic_error("RAPTOR routing engine requires the catalogue"s);
+            }
+            raptor_router_ptr_ = make_unique<RaptorRouter>(*catalogue_, bus_wait_time_, bus_velocity_);
+            break;
+        default:
+            switch (routes_table_precision_) {
+            case RoutesTablePrecision::FLOAT:
+                float_router_ptr_ = MakeAllPairsRouter(graph_, float_routes_table_, routes_table_file_, routing_threads_,
+                    page_mode_);
+                break;
+            case RoutesTablePrecision::FIXED:
+                fixed_router_ptr_ = MakeAllPairsRouter(graph_, fixed_routes_table_, routes_table_file_, routing_threads_,
+                    page_mode_);
+                break;
+            default:
+                router_ptr_ = MakeAllPairsRouter(graph_, routes_table_, routes_table_file_, routing_threads_,
+                    page_mode_);
+            }
+        }
+        if (!dijkstra_router_ptr_ && !raptor_router_ptr_) {
+            bounded_search_router_ptr_ = make_unique<graph::DijkstraRouter<double>>(graph_);
+        }
+        if (!raptor_router_ptr_) {
+            pareto_search_ = make_unique<ParetoSearch>();
+        }
+        routes_table_ = {};
+        float_routes_table_ = {};
+        fixed_routes_table_ = {};
+        contraction_hierarchy_ = {};
+        hub_labels_ = {};
+    }
+
+    std::unique_ptr<graph::HubLabelRouter<double>> Router::MakeHubLabelRouter() const {
+        // Вершины, сокращенные последними, лежат на многих кратчайших путях - из них выходят хорошие хабы
+        const graph::ContractionHierarchyRouter<double> ch_router(graph_);
+        return make_unique<graph::HubLabelRouter<double>>(graph_, ch_router.GetHierarchy().ranks);
     }
 
 } // namespace transport
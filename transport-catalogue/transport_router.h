@@ -5,13 +5,85 @@
 #include "transport_catalogue.h"
 #include "graph.h"
 #include "router.h"
+#include "dijkstra_router.h"
+#include "bidirectional_dijkstra_router.h"
+#include "lazy_router.h"
+#include "pareto_router.h"
+#include "contraction_hierarchy.h"
+#include "hub_labels.h"
+#include "raptor_router.h"
+#include "lru_cache.h"
 
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
 #include <string_view>
+#include <utility>
+#include <vector>
 
 namespace transport {
 
+    // Способ поиска маршрута, задается ключом "routing_engine" в routing_settings
+    enum class RoutingEngine {
+        ALL_PAIRS,
+        DIJKSTRA,
+        A_STAR,
+        BIDIRECTIONAL_DIJKSTRA,
+        LAZY_TABLE,
+        CONTRACTION_HIERARCHIES,
+        RAPTOR,
+        HUB_LABELS
+    };
+
+    // Модель графа, ключ "graph_model" в routing_settings: ребро на каждую пару остановок рейса
+    // (STOP_PAIRS) или вершина на каждую остановку рейса и ребра между соседними (BUS_LINES)
+    enum class GraphModel {
+        STOP_PAIRS,
+        BUS_LINES
+    };
+
+    // Порядок номеров вершин остановок, ключ "vertex_order" в routing_settings: по названиям (NAME)
+    // или по кривой Гильберта по координатам (HILBERT) - соседние остановки оказываются рядом
+    // в таблицах и списках ребер. Номера остановок хранятся в базе, поэтому порядок выбирает make_base
+    enum class VertexOrder {
+        NAME,
+        HILBERT
+    };
+
+    // Тип весов таблицы ALL_PAIRS, ключ "routes_table_precision" в routing_settings:
+    // double, float или время в фиксированной точке graph::FixedTime (FIXED, "fixed")
+    enum class RoutesTablePrecision {
+        DOUBLE,
+        FLOAT,
+        FIXED
+    };
+
+    // Ответ на запрос маршрута: общее время и элементы Wait/Bus
+    struct RouteItems {
+        double total_time = 0;
+        json::Array items;
+    };
+
+    // Вариант маршрута запроса ParetoRoute: число пересадок и сам маршрут
+    struct ParetoRouteItems {
+        size_t transfer_count = 0;
+        RouteItems route;
+    };
+
+    // Остановка, до которой можно доехать за ограниченное время, и минимальное время до нее
+    struct ReachableStop {
+        std::string_view stop_name;
+        double time = 0;
+    };
+
+    // Сколько ребер изменено обновлениями во время работы и сколько строк таблиц пересчитано
+    struct RoutingUpdateStats {
+        size_t updated_edges = 0;
+        size_t repaired_rows = 0;
+    };
+
     class Router {
 
     public:
@@ -26,29 +98,143 @@ namespace transport {
 
         void SetGraph(graph::DirectedWeightedGraph<double>&& graph,
             std::map<std::string, graph::VertexId>&& stop_ids);
+        // Таблица из файла базы, используется при следующем построении роутера вместо пересчета
+        void SetRoutesTable(graph::RoutesTable<double>&& routes_table);
+        void SetRoutesTable(graph::RoutesTable<float>&& routes_table);
+        void SetRoutesTable(graph::RoutesTable<graph::FixedTime>&& routes_table);
+        void SetContractionHierarchy(graph::ContractionHierarchy<double>&& contraction_hierarchy);
+        void SetHubLabels(graph::HubLabels<double>&& hub_labels);
+        // Таблица названий, на которые ссылаются ребра графа через name_id
+        void SetEdgeNames(std::vector<std::string>&& edge_names);
+        // Справочник для RAPTOR, который ищет маршруты по спискам остановок автобусов, а не по графу
+        void SetCatalogue(const Catalogue& tcat);
+        // Изменения во время работы, без make_base: время ожидания на всех остановках и скорость
+        // одного автобуса. Строки таблиц маршрутов, которых изменения не касаются, не пересчитываются
+        void SetBusWaitTime(int bus_wait_time);
+        void SetBusVelocity(const std::string& bus_name, double bus_velocity);
+        // Изменения из массива routing_updates: {"type": "Wait", "bus_wait_time": ...}
+        // и {"type": "Bus", "name": ..., "bus_velocity": ...}
+        void ApplyUpdates(const json::Node& updates_node);
         // Метод создания графа
         const graph::DirectedWeightedGraph<double>& BuildGraph(const Catalogue& tcat);
         json::Array GetEdgesItems(const std::vector<graph::EdgeId>& edges) const;
         std::optional<graph::Router<double>::RouteInfo> GetRouteInfo(const Stop* from, const Stop* to) const;
+        // Маршрут любым способом поиска, в том числе без ребер графа (RAPTOR)
+        std::optional<RouteItems> GetRouteItems(const Stop* from, const Stop* to) const;
+        // Маршрут через остановки stops по порядку (первая - отправление, последняя - назначение):
+        // участки между соседними остановками ищутся подряд в одном вызове на общих данных поиска
+        // потока, их элементы идут друг за другом, время складывается. nullopt - не найден хотя бы один участок
+        std::optional<RouteItems> GetViaRouteItems(const std::vector<const Stop*>& stops) const;
+        // Самые быстрые маршруты с каждым числом пересадок не больше max_transfers, при котором
+        // маршрут быстрее, чем с меньшим числом, - по возрастанию числа пересадок
+        std::vector<ParetoRouteItems> GetParetoRoutes(const Stop* from, const Stop* to, size_t max_transfers) const;
+        // Время маршрутов из каждой остановки from в каждую остановку to (nullopt - маршрута нет):
+        // один поиск на остановку отправления, чтение из таблицы ALL_PAIRS или LAZY_TABLE
+        // или слияние меток HUB_LABELS
+        std::vector<std::vector<std::optional<double>>> GetRouteMatrix(const std::vector<const Stop*>& from,
+            const std::vector<const Stop*>& to) const;
+        // Остановки, до которых можно доехать из from не дольше max_time, по возрастанию времени.
+        // Один поиск из from, ограниченный по времени, - раскрываются только достижимые вершины
+        std::vector<ReachableStop> GetReachableStops(const Stop* from, double max_time) const;
+        // Счетчики поисков DIJKSTRA, A_STAR, BIDIRECTIONAL_DIJKSTRA и LAZY_TABLE (нули для остальных способов)
+        graph::SearchStats GetSearchStats() const;
+        // Счетчики поисков запросов ParetoRoute (нули для RAPTOR)
+        graph::SearchStats GetParetoSearchStats() const;
+        RoutingUpdateStats GetUpdateStats() const;
+        // Счетчики кэша маршрутов (нули, если кэш выключен)
+        cache::CacheStats GetRouteCacheStats() const;
         size_t GetGraphVertexCount();
         const std::map<std::string, graph::VertexId>& GetStopIds() const;
         const graph::DirectedWeightedGraph<double>& GetGraph() const;
+        const std::vector<std::string>& GetEdgeNames() const;
+        // Таблица построенного роутера ALL_PAIRS (в зависимости от точности одна из трех) или nullptr,
+        // в том числе если таблица читается из файла routes_table_file
+        const graph::RoutesTable<double>* GetRoutesTable() const;
+        const graph::RoutesTable<float>* GetFloatRoutesTable() const;
+        const graph::RoutesTable<graph::FixedTime>* GetFixedRoutesTable() const;
+        const graph::ContractionHierarchy<double>* GetContractionHierarchy() const;
+        const graph::HubLabels<double>* GetHubLabels() const;
+        // Страницы памяти таблицы ALL_PAIRS и ребер графа ("huge_pages")
+        storage::PageMode GetPageMode() const;
         json::Node GetSettings() const;
 
-        ~Router() {
-            delete router_ptr_;
-        }
-
     private:
         int bus_wait_time_ = 0;
         double bus_velocity_ = 0;
+        RoutingEngine routing_engine_ = RoutingEngine::ALL_PAIRS;
+        RoutesTablePrecision routes_table_precision_ = RoutesTablePrecision::DOUBLE;
+        // Число потоков построения графа и расчета таблицы ALL_PAIRS ("routing_threads"), 0 - по числу ядер
+        size_t routing_threads_ = 0;
+        GraphModel graph_model_ = GraphModel::STOP_PAIRS;
+        VertexOrder vertex_order_ = VertexOrder::NAME;
+        // Большие страницы для таблицы ALL_PAIRS и ребер графа, ключ "huge_pages" в routing_settings:
+        // "off", "transparent" (madvise) или "explicit" (MAP_HUGETLB); без них - обычные страницы
+        storage::PageMode page_mode_ = storage::PageMode::DEFAULT;
+        // Емкость кэша маршрутов ("route_cache_size"), 0 - без кэша, и хранить ли в нем
+        // готовые элементы ответа ("route_cache_items")
+        size_t route_cache_size_ = 0;
+        bool cache_route_items_ = false;
+        // Файл таблицы ALL_PAIRS ("routes_table_file"): make_base записывает таблицу в него, а не в базу,
+        // process_requests отображает его в память. Пустая строка - таблица в базе
+        std::string routes_table_file_;
+        RoutingUpdateStats update_stats_;
 
         graph::DirectedWeightedGraph<double> graph_;
         std::map<std::string, graph::VertexId> stop_ids_;
+        // Названия остановок (в порядке вершин), затем автобусов
+        std::vector<std::string> edge_names_;
+        graph::RoutesTable<double> routes_table_;
+        graph::RoutesTable<float> float_routes_table_;
+        graph::RoutesTable<graph::FixedTime> fixed_routes_table_;
+        graph::ContractionHierarchy<double> contraction_hierarchy_;
+        graph::HubLabels<double> hub_labels_;
+        const Catalogue* catalogue_ = nullptr;
+
+        std::unique_ptr<graph::Router<double>> router_ptr_;
+        std::unique_ptr<graph::Router<double, float>> float_router_ptr_;
+        std::unique_ptr<graph::Router<double, graph::FixedTime>> fixed_router_ptr_;
+        std::unique_ptr<graph::DijkstraRouter<double>> dijkstra_router_ptr_;
+        std::unique_ptr<graph::BidirectionalDijkstraRouter<double>> bidirectional_router_ptr_;
+        std::unique_ptr<graph::LazyRouter<double>> lazy_router_ptr_;
+        std::unique_ptr<graph::ContractionHierarchyRouter<double>> ch_router_ptr_;
+        std::unique_ptr<RaptorRouter> raptor_router_ptr_;
+        std::unique_ptr<graph::HubLabelRouter<double>> hub_label_router_ptr_;
+        // Поиск Дейкстры для ограниченных по времени запросов и матриц маршрутов способов без dijkstra_router_ptr_
+        std::unique_ptr<graph::DijkstraRouter<double>> bounded_search_router_ptr_;
+        // Поиск по времени и числу посадок (ребер ожидания) для всех способов, кроме RAPTOR.
+        // Строится при первом запросе ParetoRoute, остальным запросам он не нужен
+        struct ParetoSearch {
+            std::mutex mutex;
+            std::unique_ptr<graph::ParetoRouter<double>> router;
+        };
+        std::unique_ptr<ParetoSearch> pareto_search_;
+
+        // Найденный маршрут по паре вершин, is_found = false - маршрута нет
+        struct CachedRoute {
+            bool is_found = false;
+            graph::Router<double>::RouteInfo route_info;
+            std::optional<json::Array> items;
+        };
+        using RouteCache = cache::LruCache<uint64_t, std::shared_ptr<const CachedRoute>>;
+        std::unique_ptr<RouteCache> route_cache_;
 
-        graph::Router<double>* router_ptr_ = nullptr;
+        static uint64_t GetRouteCacheKey(graph::VertexId from, graph::VertexId to);
+        std::optional<graph::Router<double>::RouteInfo> BuildRouteInfo(graph::VertexId from,
+            graph::VertexId to) const;
+        std::optional<RouteItems> BuildRouteItems(const Stop* from, const Stop* to) const;
+        // Новые веса ребер графа и обновление построенного роутера
+        void UpdateEdgeWeights(const std::vector<std::pair<graph::EdgeId, double>>& new_weights);
 
         void SetSettings(const json::Node& settings_node);
+        void BuildRouter();
+        // Метки хабов в порядке рангов иерархии сокращений
+        std::unique_ptr<graph::HubLabelRouter<double>> MakeHubLabelRouter() const;
+        // Расчет таблицы ALL_PAIRS в файл routes_table_file_
+        void WriteRoutesTableFile() const;
+        // Нижняя оценка времени пути до цели по расстоянию по прямой для A_STAR
+        graph::DijkstraRouter<double>::LowerBound MakeGeoLowerBound() const;
+        // Поиск запросов ParetoRoute, построенный при первом обращении
+        const graph::ParetoRouter<double>& GetParetoRouter() const;
     };
 
 } // namespace transport